@@ -0,0 +1,215 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * address.c (source)
+ * Decoding of Bitcoin addresses to their 20-byte hash payload.
+ *
+ * Base58Check P2PKH and P2SH addresses and bech32 P2WPKH addresses all
+ * carry a HASH160, so known addresses can be compared by payload without
+ * encoding every derived key back to text.
+ *
+ */
+
+#include "address.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+
+#include <openssl/sha.h>
+
+static const char base58[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+static const char bech32[] = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+
+/*
+ * This function decodes a Base58Check address with a one-byte version
+ * (mainnet P2PKH and P2SH) and returns 0 on success, ADDRESS_TESTNET for
+ * a testnet version.
+ */
+
+static int base58_to_hash160(const char *address, unsigned char hash[20]) {
+
+    unsigned char buf[25];
+    unsigned char check[SHA256_DIGEST_LENGTH];
+    size_t len = strlen(address);
+    size_t ones = 0;
+
+    if (len < 26 || len > 35) {
+        return -1;
+    }
+
+    memset(buf, 0, sizeof(buf));
+    for (size_t i = 0; i < len; i++) {
+        const char *p = strchr(base58, address[i]);
+        if (p == NULL) {
+            return -1;
+        }
+        unsigned int carry = (unsigned int) (p - base58);
+        for (int j = sizeof(buf) - 1; j >= 0; j--) {
+            carry += 58 * (unsigned int) buf[j];
+            buf[j] = (unsigned char) carry;
+            carry >>= 8;
+        }
+        if (carry != 0) {
+            return -1;
+        }
+    }
+
+    /* every leading '1' stands for one leading zero byte */
+    while (ones < len && address[ones] == '1') {
+        ones++;
+    }
+    for (size_t i = 0; i < sizeof(buf); i++) {
+        if (buf[i] != 0 || i == ones) {
+            if (i != ones) {
+                return -1;
+            }
+            break;
+        }
+    }
+
+    SHA256(buf, 21, check);
+    SHA256(check, sizeof(check), check);
+    if (memcmp(check, buf + 21, 4) != 0) {
+        return -1;
+    }
+
+    if (buf[0] == 0x6f || buf[0] == 0xc4) {
+        return ADDRESS_TESTNET;
+    }
+    if (buf[0] != 0x00 && buf[0] != 0x05) {
+        return -1;
+    }
+
+    memcpy(hash, buf + 1, 20);
+    return 0;
+}
+
+static unsigned int bech32_polymod_step(unsigned int chk, unsigned int value) {
+
+    static const unsigned int gen[5] = {0x3b6a57b2, 0x26508e6d, 0x1ea119fa, 0x3d4233dd, 0x2a1462b3};
+    unsigned int top = chk >> 25;
+
+    chk = ((chk & 0x1ffffff) << 5) ^ value;
+    for (int i = 0; i < 5; i++) {
+        if ((top >> i) & 1) {
+            chk ^= gen[i];
+        }
+    }
+    return chk;
+}
+
+/*
+ * This function decodes a bech32 version 0 address with a 20-byte program
+ * (P2WPKH) and returns 0 on success, ADDRESS_TESTNET for a valid tb or bcrt
+ * address.
+ */
+
+static int bech32_to_hash160(const char *address, unsigned char hash[20]) {
+
+    char lower[91];
+    unsigned char values[90];
+    size_t len = strlen(address);
+    bool hasLower = false, hasUpper = false;
+
+    if (len < 8 || len > 90) {
+        return -1;
+    }
+    for (size_t i = 0; i <= len; i++) {
+        hasLower |= islower((unsigned char) address[i]) != 0;
+        hasUpper |= isupper((unsigned char) address[i]) != 0;
+        lower[i] = (char) tolower((unsigned char) address[i]);
+    }
+    if (hasLower && hasUpper) {
+        return -1;
+    }
+
+    const char *sep = strrchr(lower, '1');
+    if (sep == NULL) {
+        return -1;
+    }
+    size_t hrpLen = (size_t) (sep - lower);
+    size_t dataLen = len - hrpLen - 1;
+    if (!((hrpLen == 2 && (strncmp(lower, "bc", 2) == 0 || strncmp(lower, "tb", 2) == 0)) ||
+          (hrpLen == 4 && strncmp(lower, "bcrt", 4) == 0)) || dataLen < 7) {
+        return -1;
+    }
+
+    unsigned int chk = 1;
+    for (size_t i = 0; i < hrpLen; i++) {
+        chk = bech32_polymod_step(chk, (unsigned int) lower[i] >> 5);
+    }
+    chk = bech32_polymod_step(chk, 0);
+    for (size_t i = 0; i < hrpLen; i++) {
+        chk = bech32_polymod_step(chk, (unsigned int) lower[i] & 31);
+    }
+    for (size_t i = 0; i < dataLen; i++) {
+        const char *p = strchr(bech32, sep[1 + i]);
+        if (p == NULL || sep[1 + i] == '\0') {
+            return -1;
+        }
+        values[i] = (unsigned char) (p - bech32);
+        chk = bech32_polymod_step(chk, values[i]);
+    }
+    if (chk != 1 || values[0] != 0) {
+        return -1;
+    }
+
+    /* regroup the 5-bit program values after the witness version */
+    unsigned int acc = 0;
+    int bits = 0;
+    size_t n = 0;
+    for (size_t i = 1; i < dataLen - 6; i++) {
+        acc = (acc << 5) | values[i];
+        bits += 5;
+        if (bits >= 8) {
+            bits -= 8;
+            if (n == 20) {
+                return -1;
+            }
+            hash[n++] = (unsigned char) (acc >> bits);
+        }
+    }
+    if (n != 20 || bits >= 5 || (acc & ((1u << bits) - 1)) != 0) {
+        return -1;
+    }
+
+    return lower[0] == 't' || hrpLen == 4 ? ADDRESS_TESTNET : 0;
+}
+
+/*
+ * This function returns the HASH160 payload of a mainnet P2PKH, P2SH or
+ * P2WPKH address in hash and 0, ADDRESS_TESTNET for a testnet or regtest
+ * address, or -1 for anything else.
+ */
+
+int address_to_hash160(const char *address, unsigned char hash[20]) {
+
+    int rc = base58_to_hash160(address, hash);
+    if (rc != -1) {
+        return rc;
+    }
+    return bech32_to_hash160(address, hash);
+}
@@ -0,0 +1,526 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * audit.c (source)
+ * Duplicate audit over batches of mnemonics.
+ *
+ * Every mnemonic is reduced to a 128-bit fingerprint, SHA256 over a random
+ * per-run key, the entropy length and the entropy. The key never leaves
+ * memory, so fingerprints reveal nothing about the phrases. Fingerprints
+ * go into an open-addressing table with linear probing, 24-byte slots
+ * holding the fingerprint and its sequence number; at a load of at most
+ * one half that is up to 48 bytes per phrase. When the table reaches the
+ * memory limit it is sorted and written to an unlinked temporary file as
+ * a run. Runs are kept in one file per merge level: AUDIT_MERGE_FANIN runs
+ * of a level are merged with a heap into one run of the next level, so
+ * the files open stay few and every record is rewritten only once per
+ * level. Only fingerprints and sequence numbers ever reach the disk.
+ *
+ * Two different phrases share a fingerprint with a probability of about
+ * n^2 / 2^129, which for any real batch size is far below hardware error.
+ *
+ */
+
+#include "audit.h"
+#include "crypto.h"
+#include "mnemonic.h"
+#include "bip39c.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include <openssl/rand.h>
+
+/*
+ * One table slot or run record; seq 0 marks an empty slot.
+ */
+
+struct audit_entry {
+    uint64_t key[2];
+    uint64_t seq;
+};
+
+static unsigned char auditKey[AUDIT_KEY_BYTES];
+static struct audit_entry *table = NULL;
+static size_t slots = 0, used = 0, maxSlots = 0, memoryLimit = 0;
+static FILE *reportFp = NULL;
+
+static uint64_t phrases = 0, duplicates = 0, invalid = 0, runsWritten = 0;
+
+/*
+ * Sorted runs of one merge level, stored back to back in one file.
+ */
+
+struct audit_level {
+    FILE *fp;
+    int count;
+    uint64_t start[AUDIT_MERGE_FANIN + 1];
+};
+
+static struct audit_level levels[AUDIT_MAX_LEVELS];
+
+/*
+ * Read side of one run during a merge.
+ */
+
+struct audit_source {
+    int fd;
+    uint64_t next, end;
+    struct audit_entry *buf;
+    size_t pos, len, cap;
+};
+
+/*
+ * This function starts an audit. The table grows up to memoryMiB and
+ * duplicates are reported to the report stream as they are found.
+ */
+
+void audit_open(unsigned long memoryMiB, FILE *report) {
+
+    if (RAND_bytes(auditKey, sizeof(auditKey)) != 1) {
+        fprintf(stderr, "ERROR: RAND_bytes failed, no entropy available.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t limit = (size_t) memoryMiB << 20;
+    memoryLimit = limit;
+    if (limit < AUDIT_MIN_SLOTS * sizeof(struct audit_entry)) {
+        fprintf(stderr, "ERROR: The audit needs at least 1 MiB of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* largest power of two whose last doubling, old and new table together, fits */
+    maxSlots = AUDIT_MIN_SLOTS;
+    while ((maxSlots + maxSlots * 2) * sizeof(struct audit_entry) <= limit) {
+        maxSlots *= 2;
+    }
+
+    slots = AUDIT_MIN_SLOTS;
+    table = calloc(slots, sizeof(struct audit_entry));
+    if (table == NULL) {
+        fprintf(stderr, "ERROR: Out of memory for the audit table.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    reportFp = report;
+}
+
+bool audit_active(void) {
+    return table != NULL;
+}
+
+static void report_duplicate(uint64_t seq, uint64_t first) {
+    fprintf(reportFp, "duplicate %llu %llu\n", (unsigned long long) seq, (unsigned long long) first);
+    duplicates++;
+}
+
+/*
+ * This function inserts a fingerprint and returns the sequence number of
+ * its first occurrence, or 0 when it is new.
+ */
+
+static uint64_t insert_key(struct audit_entry *t, size_t n, const uint64_t key[2], uint64_t seq) {
+
+    size_t mask = n - 1;
+    size_t i = (size_t) key[0] & mask;
+
+    while (t[i].seq != 0) {
+        if (t[i].key[0] == key[0] && t[i].key[1] == key[1]) {
+            return t[i].seq;
+        }
+        i = (i + 1) & mask;
+    }
+
+    t[i].key[0] = key[0];
+    t[i].key[1] = key[1];
+    t[i].seq = seq;
+    return 0;
+}
+
+static int compare_entries(const void *a, const void *b) {
+
+    const struct audit_entry *x = a, *y = b;
+
+    if (x->key[0] != y->key[0]) {
+        return x->key[0] < y->key[0] ? -1 : 1;
+    }
+    if (x->key[1] != y->key[1]) {
+        return x->key[1] < y->key[1] ? -1 : 1;
+    }
+    return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+/*
+ * This function returns the next record of a source, refilling its buffer
+ * with pread() so many runs can share one file.
+ */
+
+static bool source_next(struct audit_source *src, struct audit_entry *e) {
+
+    if (src->pos == src->len) {
+        if (src->next == src->end) {
+            return false;
+        }
+        uint64_t n = src->end - src->next;
+        size_t want = n < src->cap ? (size_t) n : src->cap;
+        ssize_t got = pread(src->fd, src->buf, want * sizeof(struct audit_entry),
+                            (off_t) (src->next * sizeof(struct audit_entry)));
+        if (got <= 0 || (size_t) got % sizeof(struct audit_entry) != 0) {
+            fprintf(stderr, "ERROR: Cannot read an audit run from a temporary file.\n");
+            exit(EXIT_FAILURE);
+        }
+        src->len = (size_t) got / sizeof(struct audit_entry);
+        src->next += src->len;
+        src->pos = 0;
+    }
+
+    *e = src->buf[src->pos++];
+    return true;
+}
+
+static void sift_down(int *heap, int size, const struct audit_entry *heads, int i) {
+
+    for (;;) {
+        int min = i, l = 2 * i + 1, r = l + 1;
+        if (l < size && compare_entries(&heads[heap[l]], &heads[heap[min]]) < 0) {
+            min = l;
+        }
+        if (r < size && compare_entries(&heads[heap[r]], &heads[heap[min]]) < 0) {
+            min = r;
+        }
+        if (min == i) {
+            return;
+        }
+        int t = heap[i];
+        heap[i] = heap[min];
+        heap[min] = t;
+        i = min;
+    }
+}
+
+/*
+ * This function merges the runs of the given levels with a min-heap and
+ * reports fingerprints seen in more than one run. Within a run every
+ * fingerprint is distinct. With out, the first record of every
+ * fingerprint is appended there as one run.
+ */
+
+static void merge_levels(int first, int final, FILE *out) {
+
+    int sourceCount = 0;
+    for (int l = first; l <= final; l++) {
+        sourceCount += levels[l].count;
+    }
+    if (sourceCount == 0) {
+        return;
+    }
+
+    /* read buffers share the memory not taken by the table */
+    size_t cap = memoryLimit / 3 / (size_t) sourceCount / sizeof(struct audit_entry);
+    cap = cap < 16 ? 16 : cap > 4096 ? 4096 : cap;
+
+    struct audit_source *sources = calloc((size_t) sourceCount, sizeof(struct audit_source));
+    struct audit_entry *heads = malloc(sizeof(struct audit_entry) * (size_t) sourceCount);
+    int *heap = malloc(sizeof(int) * (size_t) sourceCount);
+    int size = 0, n = 0;
+
+    for (int l = first; l <= final; l++) {
+        fflush(levels[l].fp);
+        for (int r = 0; r < levels[l].count; r++, n++) {
+            sources[n].fd = fileno(levels[l].fp);
+            sources[n].next = levels[l].start[r];
+            sources[n].end = levels[l].start[r + 1];
+            sources[n].cap = cap;
+            sources[n].buf = malloc(cap * sizeof(struct audit_entry));
+            if (source_next(&sources[n], &heads[n])) {
+                heap[size++] = n;
+            }
+        }
+    }
+    for (int i = size / 2 - 1; i >= 0; i--) {
+        sift_down(heap, size, heads, i);
+    }
+
+    struct audit_entry last = {{0, 0}, 0};
+    bool haveLast = false;
+
+    while (size > 0) {
+
+        int top = heap[0];
+        struct audit_entry e = heads[top];
+
+        /* equal keys arrive in sequence order, so last is the first one seen */
+        if (haveLast && e.key[0] == last.key[0] && e.key[1] == last.key[1]) {
+            report_duplicate(e.seq, last.seq);
+        } else {
+            last = e;
+            haveLast = true;
+            if (out != NULL && fwrite(&e, sizeof(e), 1, out) != 1) {
+                fprintf(stderr, "ERROR: Cannot write an audit run to a temporary file.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (!source_next(&sources[top], &heads[top])) {
+            heap[0] = heap[--size];
+        }
+        sift_down(heap, size, heads, 0);
+    }
+
+    for (int i = 0; i < sourceCount; i++) {
+        free(sources[i].buf);
+    }
+    free(sources);
+    free(heads);
+    free(heap);
+}
+
+static FILE *level_file(int l) {
+
+    if (l >= AUDIT_MAX_LEVELS) {
+        fprintf(stderr, "ERROR: Too many audit runs.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (levels[l].fp == NULL && (levels[l].fp = tmpfile()) == NULL) {
+        fprintf(stderr, "ERROR: Cannot create a temporary file for the audit.\n");
+        exit(EXIT_FAILURE);
+    }
+    fseek(levels[l].fp, 0, SEEK_END);
+    return levels[l].fp;
+}
+
+static void end_run(int l) {
+
+    FILE *fp = levels[l].fp;
+    if (fflush(fp) != 0) {
+        fprintf(stderr, "ERROR: Cannot write an audit run to a temporary file.\n");
+        exit(EXIT_FAILURE);
+    }
+    levels[l].start[++levels[l].count] = (uint64_t) ftello(fp) / sizeof(struct audit_entry);
+}
+
+/*
+ * This function merges every full level into one run of the next level
+ * and empties it for reuse.
+ */
+
+static void cascade(void) {
+
+    for (int l = 0; l < AUDIT_MAX_LEVELS && levels[l].count == AUDIT_MERGE_FANIN; l++) {
+
+        FILE *out = level_file(l + 1);
+        merge_levels(l, l, out);
+        end_run(l + 1);
+
+        if (ftruncate(fileno(levels[l].fp), 0) != 0) {
+            fprintf(stderr, "ERROR: Cannot reuse a temporary file of the audit.\n");
+            exit(EXIT_FAILURE);
+        }
+        levels[l].count = 0;
+    }
+}
+
+/*
+ * This function writes the table as a sorted run and empties it.
+ */
+
+static void spill_run(void) {
+
+    size_t n = 0;
+    for (size_t i = 0; i < slots; i++) {
+        if (table[i].seq != 0) {
+            table[n++] = table[i];
+        }
+    }
+    qsort(table, n, sizeof(struct audit_entry), compare_entries);
+
+    FILE *fp = level_file(0);
+    if (fwrite(table, sizeof(struct audit_entry), n, fp) != n) {
+        fprintf(stderr, "ERROR: Cannot write an audit run to a temporary file.\n");
+        exit(EXIT_FAILURE);
+    }
+    end_run(0);
+    runsWritten++;
+
+    memset(table, 0, slots * sizeof(struct audit_entry));
+    used = 0;
+
+    cascade();
+}
+
+/*
+ * This function doubles the table, or spills it at the memory limit.
+ */
+
+static void grow_table(void) {
+
+    if (slots >= maxSlots) {
+        spill_run();
+        return;
+    }
+
+    struct audit_entry *bigger = calloc(slots * 2, sizeof(struct audit_entry));
+    if (bigger == NULL) {
+        spill_run();
+        return;
+    }
+    for (size_t i = 0; i < slots; i++) {
+        if (table[i].seq != 0) {
+            insert_key(bigger, slots * 2, table[i].key, table[i].seq);
+        }
+    }
+    free(table);
+    table = bigger;
+    slots *= 2;
+}
+
+/*
+ * This function fingerprints count entropies, laid out stride bytes
+ * apart, and adds them under the next sequence numbers.
+ */
+
+void audit_add_batch(const unsigned char *entropies, size_t stride, int entBytes, int count) {
+
+    unsigned char msgs[MNEMONIC_BATCH][AUDIT_KEY_BYTES + 1 + ENTROPY_MAX_BYTES];
+    unsigned char digests[MNEMONIC_BATCH][32];
+    size_t len = AUDIT_KEY_BYTES + 1 + (size_t) entBytes;
+
+    while (count > 0) {
+
+        int n = count < MNEMONIC_BATCH ? count : MNEMONIC_BATCH;
+
+        for (int b = 0; b < n; b++) {
+            memcpy(msgs[b], auditKey, AUDIT_KEY_BYTES);
+            msgs[b][AUDIT_KEY_BYTES] = (unsigned char) entBytes;
+            memcpy(msgs[b] + AUDIT_KEY_BYTES + 1, entropies + b * stride, (size_t) entBytes);
+        }
+        sha256_short_batch(msgs[0], sizeof(msgs[0]), len, n, digests);
+
+        for (int b = 0; b < n; b++) {
+            uint64_t key[2];
+            memcpy(key, digests[b], sizeof(key));
+
+            phrases++;
+            uint64_t first = insert_key(table, slots, key, phrases);
+            if (first != 0) {
+                report_duplicate(phrases, first);
+            } else if (++used * 2 > slots) {
+                grow_table();
+            }
+        }
+
+        entropies += n * stride;
+        count -= n;
+    }
+}
+
+/*
+ * This function counts an input line that was not a mnemonic. It still
+ * takes a sequence number so numbers stay line numbers.
+ */
+
+void audit_add_invalid(void) {
+    phrases++;
+    invalid++;
+}
+
+/*
+ * This function ends the audit, writes the counts and returns the number
+ * of duplicates found.
+ */
+
+int audit_close(void) {
+
+    if (runsWritten > 0) {
+        spill_run();
+        merge_levels(0, AUDIT_MAX_LEVELS - 1, NULL);
+        for (int l = 0; l < AUDIT_MAX_LEVELS; l++) {
+            if (levels[l].fp != NULL) {
+                fclose(levels[l].fp);
+            }
+        }
+        memset(levels, 0, sizeof(levels));
+    }
+
+    fprintf(reportFp, "audit_phrases %llu\n", (unsigned long long) (phrases - invalid));
+    fprintf(reportFp, "audit_distinct %llu\n", (unsigned long long) (phrases - invalid - duplicates));
+    fprintf(reportFp, "audit_duplicates %llu\n", (unsigned long long) duplicates);
+    fprintf(reportFp, "audit_invalid %llu\n", (unsigned long long) invalid);
+    fprintf(reportFp, "audit_runs %llu\n", (unsigned long long) runsWritten);
+    fflush(reportFp);
+
+    free(table);
+    table = NULL;
+    memset(auditKey, 0, sizeof(auditKey));
+
+    return duplicates > 0 ? 1 : 0;
+}
+
+/*
+ * This function audits one mnemonic per line from stdin in the loaded
+ * language. Sequence numbers in the report are line numbers.
+ */
+
+int audit_mnemonics(unsigned long memoryMiB) {
+
+    unsigned char batch[MNEMONIC_BATCH][ENTROPY_MAX_BYTES + 1];
+    int indices[MNEMONIC_MAX_WORDS];
+    int n = 0, entBytes = 0;
+    char *line = NULL;
+    size_t cap = 0;
+
+    audit_open(memoryMiB, stdout);
+    setvbuf(stdin, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+    while (getline(&line, &cap, stdin) != -1) {
+
+        int count = parse_mnemonic_wordlist(language, line, indices, MNEMONIC_MAX_WORDS);
+        int bytes = count >= 12 && count % 3 == 0 ? MS_TO_ENT_BITS(count) / 8 : 0;
+
+        /* a batch holds one entropy size, keeping line order */
+        if (n > 0 && (bytes != entBytes || n == MNEMONIC_BATCH)) {
+            audit_add_batch(batch[0], sizeof(batch[0]), entBytes, n);
+            n = 0;
+        }
+
+        if (bytes == 0) {
+            audit_add_invalid();
+            continue;
+        }
+
+        pack_indices(indices, count, batch[n++]);
+        entBytes = bytes;
+    }
+
+    if (n > 0) {
+        audit_add_batch(batch[0], sizeof(batch[0]), entBytes, n);
+    }
+
+    free(line);
+
+    return audit_close();
+}
@@ -0,0 +1,63 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * audit.h (header)
+ * Duplicate audit over batches of mnemonics.
+ *
+ */
+
+#ifndef BIP39C_AUDIT_H
+#define BIP39C_AUDIT_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Defines
+ */
+
+#define AUDIT_KEY_BYTES     16
+#define AUDIT_MIN_SLOTS     (1 << 10)
+
+/* runs merged at once, and levels of merged runs (64^8 runs in all) */
+#define AUDIT_MERGE_FANIN   64
+#define AUDIT_MAX_LEVELS    8
+
+/*
+ * Function declarations
+ */
+
+void audit_open(unsigned long memoryMiB, FILE *report);
+
+bool audit_active(void);
+
+void audit_add_batch(const unsigned char *entropies, size_t stride, int entBytes, int count);
+
+void audit_add_invalid(void);
+
+int audit_close(void);
+
+int audit_mnemonics(unsigned long memoryMiB);
+
+#endif //BIP39C_AUDIT_H
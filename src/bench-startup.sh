@@ -0,0 +1,31 @@
+#!/bin/sh
+#
+# bench-startup.sh
+# Measures the exec-to-first-output time of one-shot bip39c runs, which is
+# most of the wall-clock time when bip39c is called from scripts.
+#
+# usage: bench-startup.sh <path to bip39c> [runs]
+#
+# The word files must be installed (make install) for the mnemonic cases.
+#
+
+BIP39C=${1:-./bip39c}
+RUNS=${2:-200}
+MNEMONIC="abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about"
+
+bench() {
+    label=$1
+    shift
+    start=$(date +%s%N)
+    i=0
+    while [ $i -lt $RUNS ]; do
+        "$@" > /dev/null || exit 1
+        i=$((i + 1))
+    done
+    end=$(date +%s%N)
+    echo "$label: $(( (end - start) / RUNS / 1000 )) us per run ($RUNS runs)"
+}
+
+bench "mnemonic  -e 128 -l eng" "$BIP39C" -e 128 -l eng
+bench "root seed -k" "$BIP39C" -k "$MNEMONIC"
+bench "final word -f" "$BIP39C" -f "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon" -l eng
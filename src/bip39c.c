@@ -58,10 +58,17 @@
  *
  */
 
+#include "audit.h"
 #include "bip39c.h"
 #include "conversion.h"
 #include "crypto.h"
+#include "mnemonic.h"
+#include "permute.h"
 #include "print_util.h"
+#include "recover.h"
+#include "scan.h"
+#include "translate.h"
+#include "wordlist.h"
 
 #include <unistd.h>
 #include <stdio.h>
@@ -70,6 +77,7 @@
 #include <limits.h>
 #include <string.h>
 #include <ctype.h>
+#include <openssl/crypto.h>
 #include <openssl/rand.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
@@ -78,7 +86,9 @@
  * Global variables
  */
 
-char *words[LANG_WORD_CNT];
+char **words;
+
+struct wordlist *language;
 
 /* program usage statement */
 static char const usage[] = "\
@@ -91,6 +101,30 @@ Usage: " PACKAGE_NAME " [-e] <bit value> [-l] <language code>\n\
             192\n\
             224\n\
             256\n\
+  -f    print every final word that completes 11, 14, 17, 20\n\
+        or 23 chosen words with a valid checksum\n\
+  -s    enumerate mnemonics in entropy order starting at this\n\
+        hex value (used with -e and -l)\n\
+  -n    number of mnemonics to generate or enumerate (default 1)\n\
+  -t    run SP 800-90B health tests on the random entropy and write\n\
+        a summary to this file (- for stderr)\n\
+  -r    recover the words marked ? in a mnemonic pattern\n\
+  -m    only report candidates whose root seed starts with this hex\n\
+  -P    file with one candidate passphrase per line (used with -m)\n\
+  -x    search only shard i of N disjoint shards of the keyspace\n\
+  -c    checkpoint file to record progress and resume from\n\
+  -M    merge result files, printing each distinct line once\n\
+  -o    recover the order of a mnemonic whose words are all known\n\
+  -F    word numbers, separated by commas, already in the right place\n\
+  -j    worker threads for -o (default: one per processor)\n\
+  -T    translate one mnemonic per line from stdin into this\n\
+        language; -l auto detects the language of every line\n\
+  -b    build a filter file (-a) from a file of one address per line\n\
+  -a    derive the addresses of every mnemonic and print only those\n\
+        in this filter file\n\
+  -g    addresses per chain and account to derive (default 20)\n\
+  -A    audit for duplicates in this many MiB of memory, inline\n\
+        with -e -n or over one mnemonic per line from stdin\n\
   -l    specify the language code for the mnemonic\n\
             eng   English\n\
             spa   Spanish\n\
@@ -110,16 +144,25 @@ Usage: " PACKAGE_NAME " [-e] <bit value> [-l] <language code>\n\
 
 int main(int argc, char **argv) //*argv[])
 {
-    char *evalue, *kvalue, *lvalue, *pvalue = NULL;
+    char *evalue = NULL, *fvalue = NULL, *kvalue = NULL, *lvalue = NULL, *pvalue = NULL;
+    char *nvalue = NULL, *svalue = NULL, *tvalue = NULL;
+    char *cvalue = NULL, *mvalue = NULL, *rvalue = NULL, *xvalue = NULL, *Pvalue = NULL;
+    char *avalue = NULL, *bvalue = NULL, *gvalue = NULL;
+    char *ovalue = NULL, *Fvalue = NULL, *jvalue = NULL, *Tvalue = NULL;
+    char *Avalue = NULL;
+    bool merge = false;
 
     int c;
 
+    /* no openssl.cnf, nothing here depends on it */
+    OPENSSL_init_crypto(OPENSSL_INIT_NO_LOAD_CONFIG, NULL);
+
     if (argc == 1) {
         fprintf(stderr, usage);
         exit(EXIT_FAILURE);
     }
 
-    while ((c = getopt(argc, argv, "e: l: k: p:")) != -1) {
+    while ((c = getopt(argc, argv, "a: b: c: e: f: g: j: l: k: m: n: o: p: r: s: t: x: A: F: MP: T:")) != -1) {
 
         switch (c) {
 
@@ -127,6 +170,10 @@ int main(int argc, char **argv) //*argv[])
                 evalue = optarg;
                 break;
 
+            case 'f': // final word of a partial mnemonic
+                fvalue = optarg;
+                break;
+
             case 'l': // longuage
                 lvalue = optarg;
                 break;
@@ -141,8 +188,80 @@ int main(int argc, char **argv) //*argv[])
                 pvalue = optarg;
                 break;
 
+            case 'n': // number of mnemonics
+                nvalue = optarg;
+                break;
+
+            case 's': // start of an entropy range
+                svalue = optarg;
+                break;
+
+            case 't': // entropy health tests
+                tvalue = optarg;
+                break;
+
+            case 'r': // recovery pattern
+                rvalue = optarg;
+                break;
+
+            case 'm': // target root seed
+                mvalue = optarg;
+                break;
+
+            case 'P': // passphrase candidates
+                Pvalue = optarg;
+                break;
+
+            case 'x': // keyspace shard
+                xvalue = optarg;
+                break;
+
+            case 'c': // checkpoint file
+                cvalue = optarg;
+                break;
+
+            case 'M': // merge result files
+                merge = true;
+                break;
+
+            case 'a': // address filter
+                avalue = optarg;
+                break;
+
+            case 'b': // addresses to build the filter from
+                bvalue = optarg;
+                break;
+
+            case 'g': // address gap limit
+                gvalue = optarg;
+                break;
+
+            case 'o': // mnemonic in unknown order
+                ovalue = optarg;
+                break;
+
+            case 'F': // positions known to be in place
+                Fvalue = optarg;
+                break;
+
+            case 'j': // worker threads
+                jvalue = optarg;
+                break;
+
+            case 'T': // target language
+                Tvalue = optarg;
+                break;
+
+            case 'A': // duplicate audit memory
+                Avalue = optarg;
+                break;
+
             case '?':
-                if (optopt == 'e' || optopt == 'l' || optopt == 'k' || optopt == 'p')
+                if (optopt == 'e' || optopt == 'f' || optopt == 'l' || optopt == 'k' || optopt == 'p' ||
+                    optopt == 'n' || optopt == 's' || optopt == 't' || optopt == 'r' ||
+                    optopt == 'm' || optopt == 'P' || optopt == 'x' || optopt == 'c' ||
+                    optopt == 'a' || optopt == 'b' || optopt == 'g' || optopt == 'o' ||
+                    optopt == 'F' || optopt == 'j' || optopt == 'T' || optopt == 'A')
                     fprintf(stderr, "Option -%c requires an argument.\n", optopt);
                 else if (isprint(optopt))
                     fprintf(stderr, "Unknown option `-%c'.\n", optopt);
@@ -159,113 +278,114 @@ int main(int argc, char **argv) //*argv[])
 
     } // end while
 
-    if (evalue != NULL && lvalue != NULL) {
-        /* load word file into memory */
-        get_words(lvalue);
-
-        /* convert string value to long */
-        long entropyBits = strtol(evalue, NULL, 10);
+    if (bvalue != NULL) {
+        if (avalue == NULL) {
+            fprintf(stderr, "Building a filter (-b) needs the filter file (-a) to write.\n");
+            exit(EXIT_FAILURE);
+        }
 
-        /* actual program call */
-        get_mnemonic(entropyBits);
+        /* known addresses to a mapped filter file */
+        build_address_filter(bvalue, avalue);
+        return EXIT_SUCCESS;
+    }
 
-    } else if (kvalue != NULL) {
+    if (avalue != NULL) {
+        /* candidates are matched against known addresses from here on */
+        scan_open(avalue, gvalue != NULL ? (int) strtol(gvalue, NULL, 10) : SCAN_DEFAULT_GAP, pvalue);
+    }
 
-        /* set passsphrase to empty string if null */
-        if (pvalue == NULL) {
-            pvalue = "";
+    if (merge) {
+        if (optind == argc) {
+            fprintf(stderr, "Merge (-M) needs at least one result file.\n");
+            exit(EXIT_FAILURE);
         }
 
-        /* get truly random binary seed */
-        get_root_seed(kvalue, pvalue);
+        /* sorted, distinct results of all files */
+        merge_results(argc - optind, argv + optind);
 
-    } else {
-            fprintf(stderr, "Both entropy (-e) and language (-l) options are required.\n");
+    } else if (rvalue != NULL && lvalue != NULL) {
+        /* load word file into memory */
+        get_words(lvalue);
+
+        /* search the unknown words */
+        recover_mnemonic(rvalue, mvalue, pvalue, Pvalue, xvalue, cvalue);
+
+    } else if (Tvalue != NULL && lvalue != NULL) {
+        /* index remapping between languages */
+        if (translate_mnemonics(lvalue, Tvalue) > 0) {
             exit(EXIT_FAILURE);
-    }
+        }
 
-    return EXIT_SUCCESS;
-}
+    } else if (Avalue != NULL && lvalue != NULL && evalue == NULL) {
+        /* load word file into memory */
+        get_words(lvalue);
 
-/*
- * This function implements the first part of the BIP-39 algorithm.
- * The randomness or entropy for the mnemonic must be a multiple of
- * 32 bits hence the use of 128,160,192,224,256.
- *
- * The CS values below represent a portion (in bits) of the first
- * byte of the checksum or SHA256 digest of the entropy that the user
- * chooses by program option. These checksum bits are added to the
- * entropy prior to splitting the entire random series (ENT+CS) of bits
- * into 11 bit words to be matched with the 2048 count language word
- * file chosen. The final output or mnemonic sentence consists of (MS) words.
- *
- * CS = ENT / 32
- * MS = (ENT + CS) / 11
- *
- * |  ENT  | CS | ENT+CS |  MS  |
- * +-------+----+--------+------+
- * |  128  |  4 |   132  |  12  |
- * |  160  |  5 |   165  |  15  |
- * |  192  |  6 |   198  |  18  |
- * |  224  |  7 |   231  |  21  |
- * |  256  |  8 |   264  |  24  |
- */
+        /* fingerprint every line and report repeats */
+        if (audit_mnemonics(strtoul(Avalue, NULL, 10)) > 0) {
+            exit(EXIT_FAILURE);
+        }
 
-void get_mnemonic(int entropysize) {
+    } else if (ovalue != NULL && lvalue != NULL) {
+        /* load word file into memory */
+        get_words(lvalue);
 
-    if (!(entropysize >= 128 && entropysize <= 256 && entropysize % 32 == 0)) {
-        fprintf(stderr,
-                "ERROR: Only the following values for entropy bit sizes may be used: 128, 160, 192, 224, and 256\n");
-        exit(EXIT_FAILURE);
-    }
+        /* search the word order */
+        recover_order(ovalue, Fvalue, mvalue, pvalue, jvalue != NULL ? (int) strtol(jvalue, NULL, 10) : 0);
 
+    } else if (fvalue != NULL && lvalue != NULL) {
+        /* load word file into memory */
+        get_words(lvalue);
 
-    int entBytes = entropysize / 8; // bytes instead of bits
-    int csAdd = entropysize / 32; // portion in bits of a single byte
+        /* list the checksum-valid final words */
+        get_final_words(fvalue);
 
-    /*
-     * ENT (Entropy)
-     */
+    } else if (evalue != NULL && lvalue != NULL && svalue != NULL) {
+        /* load word file into memory */
+        get_words(lvalue);
 
-    unsigned char entropy[entBytes];
-    char entropyBits[entropysize + 1];
-    entropyBits[0] = '\0';
+        /* convert string values to numbers */
+        long entropyBits = strtol(evalue, NULL, 10);
+        unsigned long long count = nvalue != NULL ? strtoull(nvalue, NULL, 10) : 1;
 
-    char binaryByte[9];
+        /* walk the entropy range */
+        enumerate_mnemonics(entropyBits, svalue, count);
 
-    /* OpenSSL */
-    int rc = RAND_bytes(entropy, sizeof(entropy));
+    } else if (evalue != NULL && lvalue != NULL) {
+        /* load word file into memory */
+        get_words(lvalue);
 
-    for (size_t i = 0; i < sizeof(entropy); i++) {
-        char buffer[3];
-        memcpy(buffer, &entropy[i], 2);
-        buffer[2] = '\0';
-        unsigned char *byte = hexstr_to_char(buffer);
-        sprintf(binaryByte, BYTE_TO_BINARY_PATTERN, BYTE_TO_BINARY(*byte));
-        binaryByte[8] = '\0';
-        strcat(entropyBits, binaryByte);
-    }
+        /* convert string values to numbers */
+        long entropyBits = strtol(evalue, NULL, 10);
+        unsigned long long count = nvalue != NULL ? strtoull(nvalue, NULL, 10) : 1;
 
-    /*
-     * ENT SHA256 checksum
-     */
+        /* the audit report goes to stderr, the mnemonics to stdout */
+        if (Avalue != NULL) {
+            audit_open(strtoul(Avalue, NULL, 10), stderr);
+        }
 
-    static char checksum[65];
-    char entropyStr[sizeof(entropy) * 2 + 1];
+        /* one random mnemonic, or a batch with -n */
+        generate_mnemonics(entropyBits, count, tvalue);
 
-    /* me and OpenSSL */
-    sha256(entropyStr, checksum);
+        if (Avalue != NULL && audit_close() > 0) {
+            exit(EXIT_FAILURE);
+        }
 
-    char hexStr[3];
-    memcpy(hexStr, &checksum[0], 2);
-    hexStr[2] = '\0';
+    } else if (kvalue != NULL) {
 
-    /*
-     * CS (Checksum portion) to add to entropy
-     */
+        /* set passsphrase to empty string if null */
+        if (pvalue == NULL) {
+            pvalue = "";
+        }
 
-    produce_mnemonic_sentence(csAdd * 33 + 1, csAdd + 1, hexStr, entropyBits);
+        /* get truly random binary seed */
+        get_root_seed(kvalue, pvalue);
+
+    } else {
+            fprintf(stderr, "Both entropy (-e) and language (-l) options are required.\n");
+            exit(EXIT_FAILURE);
+    }
 
+    return EXIT_SUCCESS;
 }
 
 /*
@@ -275,20 +395,11 @@ void get_mnemonic(int entropysize) {
 void get_root_seed(const char *pass, const char *passphrase) {
 
         /* initialize variables */
-        char HexResult[128];
-        memset(HexResult, 0, 64);
+        char HexResult[129];
         unsigned char digest[64];
 
-        /* create salt, passphrase could be empty string */
-        char *salt = malloc(strlen(passphrase) + 9);
-        salt = strcat(salt, "mnemonic");
-        salt = strcat(salt, passphrase);
-
-        /* openssl function */
-        PKCS5_PBKDF2_HMAC(pass, strlen(pass), (const unsigned char *) salt, strlen((const char *) salt), 2048, EVP_sha512(), 64, digest);
-
-        /* we're done with salt */
-        free(salt);
+        /* PBKDF2 over mnemonic and salt */
+        mnemonic_to_seed(pass, passphrase, digest);
 
         for (size_t i = 0; i < sizeof(digest); i++)
             sprintf(HexResult + (i * 2), "%02x", 255 & digest[i]);
@@ -299,148 +410,18 @@ void get_root_seed(const char *pass, const char *passphrase) {
 
 
 /*
- * This function reads the language file once and loads an array of words for
- * repeated use.
+ * This function selects the language whose words the mnemonic functions
+ * use, loading its word file on first use.
  */
 
 void get_words(char *lang) {
 
-    char *source = NULL;
-    const char *filepath = NULL;
-
-    if (strcmp(lang,"spa") == 0) {
-        filepath = "/usr/local/data/spanish.txt";
-    } else if (strcmp(lang,"eng") == 0) {
-        filepath = "/usr/local/data/english.txt";
-    } else if (strcmp(lang,"jpn") == 0) {
-        filepath = "/usr/local/data/japanese.txt";
-    } else if (strcmp(lang,"ita") == 0) {
-        filepath = "/usr/local/data/italian.txt";
-    } else if (strcmp(lang,"fra") == 0) {
-        filepath = "/usr/local/data/french.txt";
-    } else if (strcmp(lang,"kor") == 0) {
-        filepath = "/usr/local/data/korean.txt";
-    } else if (strcmp(lang,"sc") == 0) {
-        filepath = "/usr/local/data/chinese-simplified.txt";
-    } else if (strcmp(lang,"tc") == 0) {
-        filepath = "/usr/local/data/chinese-traditional.txt";
-    } else {
+    language = load_wordlist(lang);
+
+    if (language == NULL) {
         fprintf(stderr, "Language or language file does not exist.\n");
         exit(EXIT_FAILURE);
     }
 
-    FILE *fp = fopen(filepath, "r");
-
-    if (fp != NULL) {
-
-        /* Go to the end of the file. */
-        if (fseek(fp, 0L, SEEK_END) == 0) {
-
-            /* Get the size of the file. */
-            long bufsize = ftell(fp);
-
-            if (bufsize == -1) {
-                fprintf(stderr,
-                        "ERROR: File size?\n");
-            }
-
-            /* Allocate our buffer to that size. */
-            source = malloc(sizeof(char) * (bufsize + 1));
-
-            /* Go back to the start of the file. */
-            if (fseek(fp, 0L, SEEK_SET) != 0) {
-                fprintf(stderr,
-                        "ERROR: File seek beginning of file.\n");
-            }
-
-            /* Read the entire file into memory. */
-            size_t newLen;
-            newLen = fread(source, sizeof(char), (size_t) bufsize, fp);
-            if ( ferror( fp ) != 0 ) {
-                fprintf(stderr,
-                        "ERROR: File read.\n");
-            } else {
-                source[newLen++] = '\0'; /* Just to be safe. */
-            }
-        }
-        fclose(fp);
-    }
-
-    char * word;
-    word = strtok (source,"\n");
-    int i = 0;
-    while (word != NULL)
-    {
-        words[i] = malloc(strlen(word) + 1 );
-        strcpy(words[i], word);
-        i++;
-        word = strtok (NULL, "\n");
-    }
-
-    free(source);
+    words = language->words;
 }
-
-/*
- * This function prints the mnemonic sentence of size based on the segment
- * size and number of checksum bits appended to the entropy bits.
- */
-
-void produce_mnemonic_sentence(int segSize, int checksumBits, char *firstByte, char entropy[]) {
-
-    unsigned char *bytes;
-
-    char segment[segSize];
-    memset(segment, 0, segSize * sizeof(char));
-
-    char csBits[checksumBits];
-    memset(csBits, 0, checksumBits * sizeof(char));
-
-    bytes = hexstr_to_char(firstByte);
-
-    switch(checksumBits) {
-        case 5:
-            sprintf(csBits, BYTE_TO_FIRST_FOUR_BINARY_PATTERN, BYTE_TO_FIRST_FOUR_BINARY(*bytes));
-            break;
-        case 6:
-            sprintf(csBits, BYTE_TO_FIRST_FIVE_BINARY_PATTERN, BYTE_TO_FIRST_FIVE_BINARY(*bytes));
-            break;
-        case 7:
-            sprintf(csBits, BYTE_TO_FIRST_SIX_BINARY_PATTERN, BYTE_TO_FIRST_SIX_BINARY(*bytes));
-            break;
-        case 8:
-            sprintf(csBits, BYTE_TO_FIRST_SEVEN_BINARY_PATTERN, BYTE_TO_FIRST_SEVEN_BINARY(*bytes));
-            break;
-        case 9:
-            sprintf(csBits, BYTE_TO_BINARY_PATTERN, BYTE_TO_BINARY(*bytes));
-            break;
-        default:
-            exit(EXIT_FAILURE);
-            break;
-    }
-
-    csBits[checksumBits - 1] = '\0';
-
-    strcat(segment, entropy);
-    strcat(segment, csBits);
-    segment[segSize - 1] = '\0';
-
-    char elevenBits[12] = {""};
-
-    int elevenBitIndex = 0;
-    for (size_t i = 0; i < segSize; i++) {
-
-        if (elevenBitIndex == 11) {
-            elevenBits[11] = '\0';
-            long real = strtol(elevenBits, NULL, 2);
-            printf("%s", words[real]);
-            printf(" ");
-            elevenBitIndex = 0;
-        }
-
-        elevenBits[elevenBitIndex] = segment[i];
-        elevenBitIndex++;
-    }
-    printf("\n");
-}
-
-
@@ -92,15 +92,21 @@
 #define PACKAGE_NAME "bip39c"
 
 /*
- * Function declarations
+ * Global variables
  */
 
-void get_mnemonic(int entropysize);
+struct wordlist;
+
+extern char **words;
+
+extern struct wordlist *language;
 
-void produce_mnemonic_sentence(int segSize, int checksumBits, char *firstByte, char entropy[]);
+/*
+ * Function declarations
+ */
 
 void get_root_seed(const char *pass, const char *passphrase);
 
-void get_words();
+void get_words(char *lang);
 
 #endif //BIP39C_BIP39C_H
@@ -0,0 +1,120 @@
+#!/bin/sh
+#
+# check.sh
+# Known-answer tests run by make check: BIP-39 seeds, BIP-44/49/84
+# addresses, sharded recovery, audit counts, and Korean 24-word sentences,
+# whose NFKD words are the longest of all languages.
+#
+# usage: check.sh [path to bip39c]
+#
+# The word files must be installed (make install); the tests are skipped
+# otherwise.
+#
+
+BIP39C=${1:-./bip39c}
+WORDS=/usr/local/data
+
+if [ ! -f "$WORDS/english.txt" ] || [ ! -f "$WORDS/korean.txt" ]; then
+    echo "SKIP: word files are not installed in $WORDS"
+    exit 77
+fi
+
+TMP=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+TAB=$(printf '\t')
+FAILED=0
+
+check() {
+    label=$1
+    expected=$2
+    actual=$3
+    if [ "$expected" = "$actual" ]; then
+        echo "PASS: $label"
+    else
+        echo "FAIL: $label"
+        echo "  expected: $expected"
+        echo "  actual:   $actual"
+        FAILED=$((FAILED + 1))
+    fi
+}
+
+# BIP-39 root seeds of the reference vectors, passphrase TREZOR
+
+seed() {
+    check "seed $1" "$2" "$("$BIP39C" -k "$1" -p TREZOR)"
+}
+
+ABOUT="abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about"
+
+seed "$ABOUT" \
+    c55257c360c07c72029aebc1b53c05ed0362ada38ead3e3e9efa3708e53495531f09a6987599d18264c1e1c92f2cf141630c7a3c4ab7c81b2f001698e7463b04
+seed "legal winner thank year wave sausage worth useful legal winner thank yellow" \
+    2e8905819b8723fe2c1d161860e5ee1830318dbf49a83bd451cfb8440c28bd6fa457fe1296106559a3c80937a1c1069be3a3a5bd381ee6260e8d9739fce1f607
+seed "letter advice cage absurd amount doctor acoustic avoid letter advice cage above" \
+    d71de856f81a8acc65e6fc851a38d4d7ec216fd0796d0a6827a3ad6ed5511a30fa280f12eb2e47ed2ac03b5c462a0358d18d69fe4f985ec81778c1b370b652a8
+seed "zoo zoo zoo zoo zoo zoo zoo zoo zoo zoo zoo wrong" \
+    ac27495480225222079d7be181583751e86f571027b0497b5b5d11218e0a8a13332572917f0f8e5a589620c6f15b11c61dee327651a14c34e18231052e48c069
+seed "abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon art" \
+    bda85446c68413707090a52022edd26a1c9462295029f2e60cd7c4f2bbd3097170af7a4d73245cafa9c3cca8d561a7c3de6f5d4a10be8ed2a5e608d68f92fcc8
+
+# first receive address of each purpose for abandon ... about
+
+cat > "$TMP/addresses.txt" <<EOF
+1LqBGSKuX5yYUonjxT5qGfpUsXKYYWeabA
+37VucYSaXLCAsxYyAPfbSi9eh4iEcbShgf
+bc1qcr8te4kr609gcawutmrza0j4xv80jy8z306fyu
+EOF
+"$BIP39C" -b "$TMP/addresses.txt" -a "$TMP/addresses.filter" > /dev/null 2>&1
+check "addresses m/44 m/49 m/84" \
+    "m/44'/0'/0'/0/0${TAB}d986ed01b7a22225a70edbf2ba7cfb63a15cb3aa
+m/49'/0'/0'/0/0${TAB}3fb6e95812e57bb4691f9a4a628862a61a4f769b
+m/84'/0'/0'/0/0${TAB}c0cebcd6c3d3ca8c75dc5ec62ebe55330ef910e2" \
+    "$("$BIP39C" -r "${ABOUT% about} ?" -l eng -a "$TMP/addresses.filter" 2> /dev/null | cut -f 2,3)"
+
+# recovery: the shards together find exactly what one search finds
+
+PATTERN="silly blame ? equip fancy neglect giggle aunt soup lock dawn ?"
+"$BIP39C" -r "$PATTERN" -l eng 2> /dev/null | sort > "$TMP/all.txt"
+for i in 0 1 2; do
+    "$BIP39C" -r "$PATTERN" -l eng -x $i/3 > "$TMP/shard$i.txt" 2> /dev/null
+done
+check "recovery shard union" "" \
+    "$(cat "$TMP"/shard?.txt | sort | cmp "$TMP/all.txt" - 2>&1)"
+check "recovery shard merge" "" \
+    "$("$BIP39C" -M "$TMP"/shard?.txt | sort | cmp "$TMP/all.txt" - 2>&1)"
+
+printf 'wrong\nTREZOR\n' > "$TMP/passphrases.txt"
+for i in 0 1 2 3; do
+    "$BIP39C" -r "${ABOUT% about} ?" -l eng -m c55257c3 -P "$TMP/passphrases.txt" -x $i/4 \
+        -c "$TMP/shard$i.ckpt" > "$TMP/seed$i.txt" 2> /dev/null
+done
+check "recovery seed prefix and passphrase" "$ABOUT${TAB}TREZOR" \
+    "$("$BIP39C" -M "$TMP"/seed?.txt)"
+
+# audit: duplicates across spilled runs of a 1 MiB table, and invalid lines
+
+"$BIP39C" -e 128 -l eng -n 60000 > "$TMP/batch.txt"
+(cat "$TMP/batch.txt"; head -n 25 "$TMP/batch.txt"; echo "abandon zzz about") > "$TMP/audit.txt"
+"$BIP39C" -l eng -A 1 < "$TMP/audit.txt" > "$TMP/audit.out"
+check "audit counts" "audit_phrases 60025
+audit_distinct 60000
+audit_duplicates 25
+audit_invalid 1" \
+    "$(grep -E '^audit_(phrases|distinct|duplicates|invalid) ' "$TMP/audit.out")"
+check "audit duplicate lines" 25 \
+    "$(awk '$1 == "duplicate" && $2 == $3 + 60000' "$TMP/audit.out" | wc -l | tr -d ' ')"
+
+# Korean 24 words of 33 bytes each: entropy of 23 times word 114
+
+KOREAN=$("$BIP39C" -e 256 -l kor -s 0e41c8390720e41c8390720e41c8390720e41c8390720e41c8390720e41c8390)
+check "korean 24 words" 24 "$(echo "$KOREAN" | awk '{ print NF }')"
+check "korean recovery" "$KOREAN" \
+    "$("$BIP39C" -r "${KOREAN% *} ?" -l kor 2> /dev/null | grep -xF "$KOREAN")"
+check "korean translation" "$KOREAN" \
+    "$(echo "$KOREAN" | "$BIP39C" -l kor -T eng | "$BIP39C" -l auto -T kor)"
+
+if [ $FAILED -ne 0 ]; then
+    echo "$FAILED check(s) failed"
+    exit 1
+fi
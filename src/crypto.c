@@ -38,6 +38,18 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <pthread.h>
+
+#include <openssl/bn.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/obj_mac.h>
+#include <openssl/ripemd.h>
 #include <openssl/sha.h>
 
 /*
@@ -53,9 +65,457 @@ int sha256(char *string, char outputBuffer[65]) {
     SHA256_Update(&sha256, string, strlen(string));
     SHA256_Final(hash, &sha256);
     for (size_t i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        sprintf(outputBuffer + (i * 2), "%02hhX ", hash[i]);
+        sprintf(outputBuffer + (i * 2), "%02hhX", hash[i]);
     }
 
     outputBuffer[64] = 0;
     return 0;
 }
+
+/*
+ * HMAC-SHA512 for the BIP-32 derivations. On OpenSSL 3, HMAC() looks the
+ * MAC and the digest up by name on every call; here the MAC is fetched
+ * once and every thread keeps one context set up for SHA512, so a call
+ * only rekeys it.
+ */
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+
+static EVP_MAC *hmac = NULL;
+static pthread_key_t hmacKey;
+static pthread_once_t hmacOnce = PTHREAD_ONCE_INIT;
+
+static void hmac_ctx_free(void *ctx) {
+    EVP_MAC_CTX_free(ctx);
+}
+
+static void hmac_init(void) {
+
+    hmac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+    if (hmac == NULL || pthread_key_create(&hmacKey, hmac_ctx_free) != 0) {
+        fprintf(stderr, "ERROR: HMAC is not available in OpenSSL.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void hmac_sha512(const void *key, size_t keyLen, const unsigned char *data, size_t len,
+                        unsigned char digest[64]) {
+
+    size_t outLen;
+
+    pthread_once(&hmacOnce, hmac_init);
+
+    EVP_MAC_CTX *ctx = pthread_getspecific(hmacKey);
+    if (ctx == NULL) {
+        OSSL_PARAM params[] = {
+            OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, "SHA512", 0),
+            OSSL_PARAM_construct_end()
+        };
+        ctx = EVP_MAC_CTX_new(hmac);
+        if (ctx == NULL || !EVP_MAC_CTX_set_params(ctx, params)) {
+            fprintf(stderr, "ERROR: HMAC-SHA512 is not available in OpenSSL.\n");
+            exit(EXIT_FAILURE);
+        }
+        pthread_setspecific(hmacKey, ctx);
+    }
+
+    EVP_MAC_init(ctx, key, keyLen, NULL);
+    EVP_MAC_update(ctx, data, len);
+    EVP_MAC_final(ctx, digest, &outLen, 64);
+}
+
+#else
+
+static void hmac_sha512(const void *key, size_t keyLen, const unsigned char *data, size_t len,
+                        unsigned char digest[64]) {
+
+    unsigned int outLen = 64;
+
+    HMAC(EVP_sha512(), key, (int) keyLen, data, len, digest, &outLen);
+}
+
+#endif
+
+/*
+ * This function stretches a mnemonic sentence and passphrase into the
+ * 512-bit root seed with PBKDF2 and 2048 rounds of HMAC-SHA512. Its time
+ * is all in the rounds; a prefetched digest or reused KDF context makes no
+ * measurable difference.
+ */
+
+void mnemonic_to_seed(const char *mnemonic, const char *passphrase, unsigned char seed[64]) {
+
+    /* create salt, passphrase could be empty string */
+    size_t passLen = strlen(passphrase);
+    char *salt = malloc(passLen + 9);
+    memcpy(salt, "mnemonic", 8);
+    memcpy(salt + 8, passphrase, passLen + 1);
+
+    /* openssl function */
+    PKCS5_PBKDF2_HMAC(mnemonic, strlen(mnemonic), (const unsigned char *) salt, (int) (passLen + 8), 2048,
+                      EVP_sha512(), 64, seed);
+
+    /* we're done with salt */
+    free(salt);
+}
+
+/*
+ * This function computes RIPEMD160(SHA256(data)), the payload of P2PKH,
+ * P2SH and P2WPKH addresses.
+ */
+
+void hash160(const unsigned char *data, size_t len, unsigned char digest[20]) {
+
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+
+    SHA256(data, len, hash);
+
+    /* deprecated in OpenSSL 3, but the EVP path costs a fetch per call */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    RIPEMD160(hash, sizeof(hash), digest);
+#pragma GCC diagnostic pop
+}
+
+/*
+ * The secp256k1 group is created once, with generator precomputation, and
+ * only read afterwards so it can be shared between threads.
+ *
+ * The precomputed table and EC_POINTs_mul() are deprecated in OpenSSL 3
+ * without a replacement for the multi-term product, so their warnings are
+ * silenced where they are used.
+ */
+
+static EC_GROUP *secp256k1 = NULL;
+static pthread_once_t secp256k1Once = PTHREAD_ONCE_INIT;
+
+static void secp256k1_init(void) {
+
+    secp256k1 = EC_GROUP_new_by_curve_name(NID_secp256k1);
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    if (secp256k1 == NULL || EC_GROUP_precompute_mult(secp256k1, NULL) != 1) {
+#pragma GCC diagnostic pop
+        fprintf(stderr, "ERROR: secp256k1 is not available in OpenSSL.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+ * This function derives the BIP-32 master key from a root seed.
+ */
+
+void hd_master(const unsigned char seed[64], struct hd_node *node) {
+
+    unsigned char digest[64];
+
+    hmac_sha512("Bitcoin seed", 12, seed, 64, digest);
+
+    memcpy(node->key, digest, 32);
+    memcpy(node->chain, digest + 32, 32);
+}
+
+/*
+ * This function writes the compressed public key of a node.
+ *
+ * k * G alone takes OpenSSL's constant-time ladder, which ignores the
+ * precomputed generator table. Written as (k - 1) * G + 1 * G it goes
+ * through the windowed multiplication instead, several times faster. The
+ * keys are candidates searched on the user's own machine, where the timing
+ * of one multiplication tells nobody anything.
+ */
+
+void hd_public_key(const struct hd_node *node, unsigned char pub[33]) {
+
+    pthread_once(&secp256k1Once, secp256k1_init);
+
+    BN_CTX *ctx = BN_CTX_new();
+    BIGNUM *k = BN_bin2bn(node->key, 32, NULL);
+    BIGNUM *one = BN_new();
+    EC_POINT *point = EC_POINT_new(secp256k1);
+    const EC_POINT *points[1] = {EC_GROUP_get0_generator(secp256k1)};
+    const BIGNUM *scalars[1] = {one};
+
+    BN_one(one);
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    if (BN_is_one(k) || !BN_sub_word(k, 1) || !EC_POINTs_mul(secp256k1, point, k, 1, points, scalars, ctx)) {
+        /* k = 1 would leave a zero scalar, which the windowed path skips */
+        BN_bin2bn(node->key, 32, k);
+        EC_POINT_mul(secp256k1, point, k, NULL, NULL, ctx);
+    }
+#pragma GCC diagnostic pop
+    EC_POINT_point2oct(secp256k1, point, POINT_CONVERSION_COMPRESSED, pub, 33, ctx);
+
+    EC_POINT_free(point);
+    BN_free(one);
+    BN_clear_free(k);
+    BN_CTX_free(ctx);
+}
+
+/*
+ * This function derives a private child key (CKDpriv). A normal child
+ * needs the parent's public key, which callers deriving many siblings pass
+ * in; NULL computes it. Returns -1 for the rare index without a valid key.
+ */
+
+int hd_child(const struct hd_node *parent, const unsigned char *parentPub, unsigned int index,
+             struct hd_node *child) {
+
+    unsigned char data[37];
+    unsigned char digest[64];
+    unsigned char pub[33];
+    int rc = 0;
+
+    pthread_once(&secp256k1Once, secp256k1_init);
+
+    if (index & HD_HARDENED) {
+        data[0] = 0;
+        memcpy(data + 1, parent->key, 32);
+    } else {
+        if (parentPub == NULL) {
+            hd_public_key(parent, pub);
+            parentPub = pub;
+        }
+        memcpy(data, parentPub, 33);
+    }
+    data[33] = (unsigned char) (index >> 24);
+    data[34] = (unsigned char) (index >> 16);
+    data[35] = (unsigned char) (index >> 8);
+    data[36] = (unsigned char) index;
+
+    hmac_sha512(parent->chain, 32, data, sizeof(data), digest);
+
+    BN_CTX *ctx = BN_CTX_new();
+    const BIGNUM *order = EC_GROUP_get0_order(secp256k1);
+    BIGNUM *il = BN_bin2bn(digest, 32, NULL);
+    BIGNUM *k = BN_bin2bn(parent->key, 32, NULL);
+
+    if (BN_cmp(il, order) >= 0 || !BN_mod_add(k, k, il, order, ctx) || BN_is_zero(k)) {
+        rc = -1;
+    } else {
+        BN_bn2binpad(k, child->key, 32);
+        memcpy(child->chain, digest + 32, 32);
+    }
+
+    BN_clear_free(il);
+    BN_clear_free(k);
+    BN_CTX_free(ctx);
+
+    return rc;
+}
+
+/*
+ * This function derives the public keys of count consecutive normal
+ * children straight from the parent's public key (CKDpub), as IL * G +
+ * parent. A child without a valid key gets an all-zero entry; the number of
+ * such children is returned. With chains the child chain codes are
+ * written too, for deriving further down the path.
+ *
+ * EC_POINT_mul() with only a generator scalar takes OpenSSL's constant-time
+ * ladder. The two-term sum goes through the windowed multiplication, which
+ * uses the precomputed generator table and is several times faster; IL of
+ * a public derivation is no secret of the parent. The parent point is
+ * decompressed once for all siblings, and the children are brought to
+ * affine form together, with one field inversion instead of one each.
+ */
+
+int hd_children_public(const unsigned char parentPub[33], const unsigned char chain[32], unsigned int first,
+                       int count, unsigned char pubs[][33], unsigned char chains[][32]) {
+
+    unsigned char data[37];
+    unsigned char digest[64];
+    int invalid = 0;
+
+    pthread_once(&secp256k1Once, secp256k1_init);
+
+    BN_CTX *ctx = BN_CTX_new();
+    BIGNUM *il = BN_new();
+    BIGNUM *one = BN_new();
+    EC_POINT *parent = EC_POINT_new(secp256k1);
+    EC_POINT **children = calloc((size_t) (count > 0 ? count : 1), sizeof(EC_POINT *));
+    int *slots = malloc(sizeof(int) * (size_t) (count > 0 ? count : 1));
+    int valid = 0;
+    const EC_POINT *points[1] = {parent};
+    const BIGNUM *scalars[1] = {one};
+    const BIGNUM *order = EC_GROUP_get0_order(secp256k1);
+
+    BN_one(one);
+    memcpy(data, parentPub, 33);
+
+    if (!EC_POINT_oct2point(secp256k1, parent, parentPub, 33, ctx)) {
+        memset(pubs, 0, (size_t) count * 33);
+        invalid = count;
+        count = 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+
+        unsigned int index = first + (unsigned int) i;
+        data[33] = (unsigned char) (index >> 24);
+        data[34] = (unsigned char) (index >> 16);
+        data[35] = (unsigned char) (index >> 8);
+        data[36] = (unsigned char) index;
+
+        hmac_sha512(chain, 32, data, sizeof(data), digest);
+        BN_bin2bn(digest, 32, il);
+        if (chains != NULL) {
+            memcpy(chains[i], digest + 32, 32);
+        }
+
+        if (children[valid] == NULL) {
+            children[valid] = EC_POINT_new(secp256k1);
+        }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+        if (BN_cmp(il, order) >= 0 ||
+            !EC_POINTs_mul(secp256k1, children[valid], il, 1, points, scalars, ctx) ||
+            EC_POINT_is_at_infinity(secp256k1, children[valid])) {
+            memset(pubs[i], 0, 33);
+            invalid++;
+        } else {
+            slots[valid++] = i;
+        }
+#pragma GCC diagnostic pop
+    }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    EC_POINTs_make_affine(secp256k1, (size_t) valid, children, ctx);
+#pragma GCC diagnostic pop
+    for (int v = 0; v < valid; v++) {
+        EC_POINT_point2oct(secp256k1, children[v], POINT_CONVERSION_COMPRESSED, pubs[slots[v]], 33, ctx);
+    }
+
+    for (int i = 0; i < count; i++) {
+        EC_POINT_free(children[i]);
+    }
+    free(children);
+    free(slots);
+    EC_POINT_free(parent);
+    BN_free(one);
+    BN_clear_free(il);
+    BN_CTX_free(ctx);
+
+    return invalid;
+}
+
+/*
+ * SHA256 round constants (FIPS 180-4, section 4.2.2).
+ */
+
+static const unsigned int K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const unsigned int H256[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+#define ROTR32(x, n)    (((x) >> (n)) | ((x) << (32 - (n))))
+
+/*
+ * This function hashes SHA256_LANES equal-length short messages in one
+ * interleaved pass. Every lane is a separate 32-bit column, so the compiler
+ * can keep all lanes in vector registers while walking the 64 rounds once.
+ */
+
+static void sha256_short_lanes(const unsigned char *msgs, size_t stride, size_t len, int count,
+                               unsigned char digests[][32]) {
+
+    unsigned int w[64][SHA256_LANES];
+    unsigned int st[8][SHA256_LANES];
+    unsigned char block[64];
+    int l, t;
+
+    /* message schedule words 0..15 from the padded single block */
+    for (l = 0; l < SHA256_LANES; l++) {
+        memset(block, 0, sizeof(block));
+        if (l < count) {
+            memcpy(block, msgs + l * stride, len);
+        }
+        block[len] = 0x80;
+        block[62] = (unsigned char) ((len * 8) >> 8);
+        block[63] = (unsigned char) (len * 8);
+        for (t = 0; t < 16; t++) {
+            w[t][l] = (unsigned int) block[t * 4] << 24 | (unsigned int) block[t * 4 + 1] << 16 |
+                      (unsigned int) block[t * 4 + 2] << 8 | block[t * 4 + 3];
+        }
+    }
+
+    for (t = 16; t < 64; t++) {
+        for (l = 0; l < SHA256_LANES; l++) {
+            unsigned int x = w[t - 15][l], y = w[t - 2][l];
+            unsigned int s0 = ROTR32(x, 7) ^ ROTR32(x, 18) ^ (x >> 3);
+            unsigned int s1 = ROTR32(y, 17) ^ ROTR32(y, 19) ^ (y >> 10);
+            w[t][l] = w[t - 16][l] + s0 + w[t - 7][l] + s1;
+        }
+    }
+
+    for (t = 0; t < 8; t++) {
+        for (l = 0; l < SHA256_LANES; l++) {
+            st[t][l] = H256[t];
+        }
+    }
+
+    for (t = 0; t < 64; t++) {
+        for (l = 0; l < SHA256_LANES; l++) {
+            unsigned int a = st[0][l], b = st[1][l], c = st[2][l], d = st[3][l];
+            unsigned int e = st[4][l], f = st[5][l], g = st[6][l], h = st[7][l];
+            unsigned int t1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) +
+                              ((e & f) ^ (~e & g)) + K256[t] + w[t][l];
+            unsigned int t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) +
+                              ((a & b) ^ (a & c) ^ (b & c));
+            st[7][l] = g;
+            st[6][l] = f;
+            st[5][l] = e;
+            st[4][l] = d + t1;
+            st[3][l] = c;
+            st[2][l] = b;
+            st[1][l] = a;
+            st[0][l] = t1 + t2;
+        }
+    }
+
+    for (l = 0; l < count; l++) {
+        for (t = 0; t < 8; t++) {
+            unsigned int v = st[t][l] + H256[t];
+            digests[l][t * 4] = (unsigned char) (v >> 24);
+            digests[l][t * 4 + 1] = (unsigned char) (v >> 16);
+            digests[l][t * 4 + 2] = (unsigned char) (v >> 8);
+            digests[l][t * 4 + 3] = (unsigned char) v;
+        }
+    }
+}
+
+/*
+ * This function computes raw SHA256 digests for count messages of the same
+ * length (at most SHA256_SHORT_MAX bytes) laid out stride bytes apart. BIP-39
+ * entropy is always a single block, which is what makes the batching cheap.
+ */
+
+void sha256_short_batch(const unsigned char *msgs, size_t stride, size_t len, int count,
+                        unsigned char digests[][32]) {
+
+    if (len > SHA256_SHORT_MAX) {
+        fprintf(stderr, "ERROR: Message too long for a single SHA256 block.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    while (count > 0) {
+        int n = count < SHA256_LANES ? count : SHA256_LANES;
+        sha256_short_lanes(msgs, stride, len, n, digests);
+        msgs += n * stride;
+        digests += n;
+        count -= n;
+    }
+}
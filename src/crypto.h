@@ -35,6 +35,43 @@
 #ifndef BIP39C_CRYPTO_H
 #define BIP39C_CRYPTO_H
 
+#include <stddef.h>
+
+/* number of messages hashed side by side by sha256_short_batch() */
+#define SHA256_LANES    8
+
+/* longest message that still fits a single padded SHA256 block */
+#define SHA256_SHORT_MAX    55
+
+/* hardened BIP-32 child index */
+#define HD_HARDENED     0x80000000u
+
+/*
+ * BIP-32 extended private key
+ */
+
+struct hd_node {
+    unsigned char key[32];
+    unsigned char chain[32];
+};
+
 int sha256(char *string, char outputBuffer[65]);
 
+void mnemonic_to_seed(const char *mnemonic, const char *passphrase, unsigned char seed[64]);
+
+void hash160(const unsigned char *data, size_t len, unsigned char digest[20]);
+
+void hd_master(const unsigned char seed[64], struct hd_node *node);
+
+int hd_child(const struct hd_node *parent, const unsigned char *parentPub, unsigned int index,
+             struct hd_node *child);
+
+void hd_public_key(const struct hd_node *node, unsigned char pub[33]);
+
+int hd_children_public(const unsigned char parentPub[33], const unsigned char chain[32], unsigned int first,
+                       int count, unsigned char pubs[][33], unsigned char chains[][32]);
+
+void sha256_short_batch(const unsigned char *msgs, size_t stride, size_t len, int count,
+                        unsigned char digests[][32]);
+
 #endif //BIP39C_CRYPTO_H
@@ -0,0 +1,158 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * health.c (source)
+ * Streaming health tests on the random entropy stream.
+ *
+ * The repetition count and adaptive proportion tests of SP 800-90B run on
+ * every byte returned by RAND_bytes, and a histogram counts how often each
+ * word index is produced. A failing test stops generation before the
+ * mnemonics of the failing batch are written, and the summary names it.
+ *
+ */
+
+#include "health.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * This function resets all counters.
+ */
+
+void health_init(struct health_stats *hs) {
+    memset(hs, 0, sizeof(*hs));
+}
+
+/*
+ * This function feeds entropy bytes through both SP 800-90B tests and
+ * returns 0, or -1 as soon as a cutoff is reached.
+ */
+
+int health_test_bytes(struct health_stats *hs, const unsigned char *bytes, size_t len) {
+
+    for (size_t i = 0; i < len; i++) {
+
+        unsigned char x = bytes[i];
+
+        /* repetition count test: runs of the same byte */
+        if (hs->samples > 0 && x == hs->rctLast) {
+            if (++hs->rctRun > hs->rctMaxRun) {
+                hs->rctMaxRun = hs->rctRun;
+            }
+            if (hs->rctRun >= HEALTH_RCT_CUTOFF) {
+                fprintf(stderr, "ERROR: Repetition count test failed after %llu bytes (%u repeats).\n",
+                        hs->samples, hs->rctRun);
+                hs->failed = "repetition_count";
+                return -1;
+            }
+        } else {
+            hs->rctLast = x;
+            hs->rctRun = 1;
+        }
+
+        /* adaptive proportion test: count of the first byte in each window */
+        if (hs->aptPos == 0) {
+            hs->aptRef = x;
+            hs->aptCount = 1;
+            if (hs->aptMaxCount == 0) {
+                hs->aptMaxCount = 1;
+            }
+        } else if (x == hs->aptRef) {
+            if (++hs->aptCount > hs->aptMaxCount) {
+                hs->aptMaxCount = hs->aptCount;
+            }
+            if (hs->aptCount >= HEALTH_APT_CUTOFF) {
+                fprintf(stderr, "ERROR: Adaptive proportion test failed after %llu bytes (%u of %d).\n",
+                        hs->samples, hs->aptCount, HEALTH_APT_WINDOW);
+                hs->failed = "adaptive_proportion";
+                return -1;
+            }
+        }
+        if (++hs->aptPos == HEALTH_APT_WINDOW) {
+            hs->aptPos = 0;
+            hs->aptWindows++;
+        }
+
+        hs->samples++;
+    }
+
+    return 0;
+}
+
+/*
+ * This function adds the word indices of one mnemonic to the histogram.
+ */
+
+void health_count_words(struct health_stats *hs, const int indices[], int count) {
+
+    for (int i = 0; i < count; i++) {
+        hs->wordCount[indices[i]]++;
+    }
+    hs->wordTotal += (unsigned long long) count;
+}
+
+/*
+ * This function writes a summary of the test counters and the word
+ * histogram. The chi-square statistic of the histogram against a uniform
+ * distribution has 2047 degrees of freedom, so values far from 2047
+ * (more than about 5 * 64) deserve a closer look.
+ */
+
+void health_write_summary(const struct health_stats *hs, FILE *fp) {
+
+    unsigned long long minCount = hs->wordCount[0], maxCount = hs->wordCount[0];
+    double expected = (double) hs->wordTotal / LANG_WORD_CNT;
+    double chiSquare = 0.0;
+
+    for (int i = 0; i < LANG_WORD_CNT; i++) {
+        unsigned long long n = hs->wordCount[i];
+        if (n < minCount) {
+            minCount = n;
+        }
+        if (n > maxCount) {
+            maxCount = n;
+        }
+        if (expected > 0.0) {
+            chiSquare += ((double) n - expected) * ((double) n - expected) / expected;
+        }
+    }
+
+    fprintf(fp, "health_failed %s\n", hs->failed != NULL ? hs->failed : "none");
+    fprintf(fp, "entropy_bytes %llu\n", hs->samples);
+    fprintf(fp, "rct_cutoff %d\n", HEALTH_RCT_CUTOFF);
+    fprintf(fp, "rct_max_run %u\n", hs->rctMaxRun);
+    fprintf(fp, "apt_window %d\n", HEALTH_APT_WINDOW);
+    fprintf(fp, "apt_cutoff %d\n", HEALTH_APT_CUTOFF);
+    fprintf(fp, "apt_windows %llu\n", hs->aptWindows);
+    fprintf(fp, "apt_max_count %u\n", hs->aptMaxCount);
+    fprintf(fp, "words %llu\n", hs->wordTotal);
+    fprintf(fp, "word_count_min %llu\n", minCount);
+    fprintf(fp, "word_count_max %llu\n", maxCount);
+    fprintf(fp, "word_chi_square %.2f\n", chiSquare);
+    fprintf(fp, "word_histogram");
+    for (int i = 0; i < LANG_WORD_CNT; i++) {
+        fprintf(fp, " %llu", hs->wordCount[i]);
+    }
+    fprintf(fp, "\n");
+}
@@ -0,0 +1,88 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * health.h (header)
+ * Streaming health tests on the random entropy stream.
+ *
+ */
+
+#ifndef BIP39C_HEALTH_H
+#define BIP39C_HEALTH_H
+
+#include "bip39c.h"
+
+#include <stdio.h>
+#include <stddef.h>
+
+/*
+ * Defines
+ *
+ * Cutoffs follow SP 800-90B section 4.4 for byte samples with an assessed
+ * min-entropy of 8 bits per byte and a false positive rate of 2^-40.
+ */
+
+#define HEALTH_RCT_CUTOFF   6       /* 1 + ceil(40 / 8) */
+#define HEALTH_APT_WINDOW   512
+#define HEALTH_APT_CUTOFF   19      /* 1 + CRITBINOM(512, 2^-8, 1 - 2^-40) */
+
+/*
+ * Running state of the health tests. All counters are updated per sample
+ * and the whole struct stays in cache during batch generation.
+ */
+
+struct health_stats {
+    unsigned long long samples;
+
+    /* name of the test that failed, or NULL */
+    const char *failed;
+
+    /* repetition count test */
+    unsigned char rctLast;
+    unsigned int rctRun;
+    unsigned int rctMaxRun;
+
+    /* adaptive proportion test */
+    unsigned char aptRef;
+    unsigned int aptCount;
+    unsigned int aptPos;
+    unsigned int aptMaxCount;
+    unsigned long long aptWindows;
+
+    /* word index frequency histogram */
+    unsigned long long wordTotal;
+    unsigned long long wordCount[LANG_WORD_CNT];
+};
+
+/*
+ * Function declarations
+ */
+
+void health_init(struct health_stats *hs);
+
+int health_test_bytes(struct health_stats *hs, const unsigned char *bytes, size_t len);
+
+void health_count_words(struct health_stats *hs, const int indices[], int count);
+
+void health_write_summary(const struct health_stats *hs, FILE *fp);
+
+#endif //BIP39C_HEALTH_H
@@ -0,0 +1,569 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * mnemonic.c (source)
+ * Bit-level mnemonic functions working on 11-bit word indices.
+ *
+ * The string functions in bip39c.c build a '0'/'1' character for every
+ * bit. Searches that look at thousands or millions of sentences work on
+ * the packed form instead: a sentence is an array of word indices and
+ * ENT+CS is a big-endian bit string of 11 bits per word.
+ *
+ */
+
+#include "mnemonic.h"
+#include "audit.h"
+#include "bip39c.h"
+#include "conversion.h"
+#include "crypto.h"
+#include "health.h"
+#include "scan.h"
+#include "wordlist.h"
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/rand.h>
+
+/*
+ * This function returns the index of a word in the loaded language
+ * file or -1 if the word is not in the list.
+ */
+
+int word_index(const char *word) {
+    return wordlist_index(language, word, strlen(word));
+}
+
+/*
+ * Bytes that can start a word separator: ASCII whitespace, and the lead
+ * byte of the ideographic space used by Japanese sentences.
+ */
+
+static const bool separatorStart[256] = {
+    [' '] = true, ['\t'] = true, ['\n'] = true, ['\r'] = true, [0xe3] = true
+};
+
+/*
+ * This function returns the length of the word separator at s, or 0. The
+ * ideographic space is matched as a fixed three-byte sequence, stopping
+ * at a NUL.
+ */
+
+static inline int separator_len(const char *s) {
+
+    unsigned char c = (unsigned char) *s;
+
+    if (!separatorStart[c]) {
+        return 0;
+    }
+    if (c != 0xe3) {
+        return 1;
+    }
+    return (unsigned char) s[1] == 0x80 && (unsigned char) s[2] == 0x80 ? 3 : 0;
+}
+
+/*
+ * This function splits a sentence into word indices of a language and
+ * returns the number of words, or -1 on an unknown word or too many words.
+ * A "?" becomes WORD_UNKNOWN when unknown words are allowed. Words are
+ * looked up in place, without copying them out of the sentence.
+ */
+
+static int parse_words(struct wordlist *wl, const char *sentence, int indices[], int maxWords,
+                       bool allowUnknown, bool report) {
+
+    int count = 0;
+    const char *p = sentence;
+
+    for (;;) {
+
+        int sep;
+        while ((sep = separator_len(p)) > 0) {
+            p += sep;
+        }
+        if (*p == '\0') {
+            break;
+        }
+
+        const char *word = p;
+        while (*p != '\0' && separator_len(p) == 0) {
+            p++;
+        }
+        size_t len = (size_t) (p - word);
+
+        if (count == maxWords) {
+            if (report) {
+                fprintf(stderr, "ERROR: Too many words, at most %d are allowed.\n", maxWords);
+            }
+            return -1;
+        }
+
+        if (allowUnknown && len == 1 && *word == '?') {
+            indices[count++] = WORD_UNKNOWN;
+            continue;
+        }
+
+        indices[count] = wordlist_index(wl, word, len);
+        if (indices[count] < 0) {
+            if (report) {
+                fprintf(stderr, "ERROR: Word '%.*s' is not in the language file.\n", (int) len, word);
+            }
+            return -1;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+/*
+ * This function splits a mnemonic sentence into word indices and returns the
+ * number of words, or -1 if a word is unknown or there are too many words.
+ */
+
+int parse_mnemonic(const char *sentence, int indices[], int maxWords) {
+    return parse_words(language, sentence, indices, maxWords, false, true);
+}
+
+/*
+ * This function works like parse_mnemonic() but accepts "?" for a word
+ * that is not known, which is stored as WORD_UNKNOWN.
+ */
+
+int parse_mnemonic_pattern(const char *pattern, int indices[], int maxWords) {
+    return parse_words(language, pattern, indices, maxWords, true, true);
+}
+
+/*
+ * This function works like parse_mnemonic() for the words of a given
+ * language, and fails without a message so callers can try another one.
+ */
+
+int parse_mnemonic_wordlist(struct wordlist *wl, const char *sentence, int indices[], int maxWords) {
+    return parse_words(wl, sentence, indices, maxWords, false, false);
+}
+
+/*
+ * This function packs count 11-bit indices into a big-endian bit string.
+ * The buffer must hold (count * 11 + 7) / 8 bytes; unused trailing bits
+ * are cleared.
+ */
+
+void pack_indices(const int indices[], int count, unsigned char *bytes) {
+
+    unsigned int acc = 0;
+    int bits = 0;
+    int n = 0;
+
+    for (int i = 0; i < count; i++) {
+        acc = (acc << 11) | (unsigned int) indices[i];
+        bits += 11;
+        while (bits >= 8) {
+            bits -= 8;
+            bytes[n++] = (unsigned char) (acc >> bits);
+        }
+    }
+
+    if (bits > 0) {
+        bytes[n] = (unsigned char) (acc << (8 - bits));
+    }
+}
+
+/*
+ * This function reads the 11-bit indices first..count-1 from a big-endian
+ * bit string. Indices before first are left untouched.
+ */
+
+void unpack_indices(const unsigned char *bytes, int first, int count, int indices[]) {
+
+    unsigned int acc = 0;
+    int bits = 0;
+    int n = first * 11 / 8;
+
+    /* start inside a byte whose leading bits belong to the previous word */
+    if ((first * 11) % 8 != 0) {
+        acc = bytes[n++];
+        bits = 8 - (first * 11) % 8;
+    }
+
+    for (int i = first; i < count; i++) {
+        while (bits < 11) {
+            acc = (acc << 8) | bytes[n++];
+            bits += 8;
+        }
+        bits -= 11;
+        indices[i] = (int) ((acc >> bits) & 0x7ff);
+    }
+}
+
+/*
+ * This function splits ENT+CS into word indices, taking the CS bits from
+ * the first byte of the entropy's SHA256 digest.
+ *
+ * CS = ENT / 32
+ * MS = (ENT + CS) / 11
+ *
+ * |  ENT  | CS | ENT+CS |  MS  |
+ * +-------+----+--------+------+
+ * |  128  |  4 |   132  |  12  |
+ * |  160  |  5 |   165  |  15  |
+ * |  192  |  6 |   198  |  18  |
+ * |  224  |  7 |   231  |  21  |
+ * |  256  |  8 |   264  |  24  |
+ */
+
+void entropy_to_indices(const unsigned char *entropy, int entBytes, const unsigned char *digest,
+                        int indices[]) {
+
+    unsigned char segment[ENTROPY_MAX_BYTES + 1];
+
+    memcpy(segment, entropy, (size_t) entBytes);
+    segment[entBytes] = digest[0];
+
+    unpack_indices(segment, 0, ENT_BITS_TO_MS(entBytes * 8), indices);
+}
+
+/*
+ * This function formats a mnemonic sentence, words separated by a space,
+ * into a buffer of size bytes (MNEMONIC_MAX_BYTES holds any sentence) and
+ * returns its length.
+ */
+
+size_t format_mnemonic(char *sentence, size_t size, const int indices[], int count) {
+
+    size_t len = 0;
+
+    for (int i = 0; i < count; i++) {
+        size_t wordLen = strlen(words[indices[i]]);
+        if (len + wordLen + 2 > size) {
+            fprintf(stderr, "ERROR: Mnemonic sentence does not fit in %zu bytes.\n", size);
+            exit(EXIT_FAILURE);
+        }
+        if (i > 0) {
+            sentence[len++] = ' ';
+        }
+        memcpy(sentence + len, words[indices[i]], wordLen);
+        len += wordLen;
+    }
+    sentence[len] = '\0';
+
+    return len;
+}
+
+/*
+ * This function writes a mnemonic sentence followed by a newline.
+ */
+
+void write_mnemonic(FILE *fp, const int indices[], int count) {
+
+    for (int i = 0; i < count; i++) {
+        if (i > 0) {
+            putc(' ', fp);
+        }
+        fputs(words[indices[i]], fp);
+    }
+    putc('\n', fp);
+}
+
+/*
+ * This function prints every final word that completes a user-chosen
+ * sentence of 11, 14, 17, 20 or 23 words with a valid checksum.
+ *
+ * The last word holds the lowest (11 - CS) bits of the entropy and the CS
+ * checksum bits. The partial entropy is packed once, and only the free
+ * entropy bits are enumerated: 128 candidates for 12 words down to 8 for
+ * 24 words. All candidates are hashed together in one batch.
+ */
+
+void get_final_words(const char *partial) {
+
+    int indices[MNEMONIC_MAX_WORDS];
+
+    int count = parse_mnemonic(partial, indices, MNEMONIC_MAX_WORDS - 1);
+    if (count < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    int ms = count + 1;
+    if (ms < 12 || ms % 3 != 0) {
+        fprintf(stderr,
+                "ERROR: Only the following word counts may be completed: 11, 14, 17, 20, and 23\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int entBytes = MS_TO_ENT_BITS(ms) / 8;
+    int csBits = MS_TO_CS_BITS(ms);
+    int candidates = 1 << (11 - csBits);
+
+    unsigned char partialEntropy[ENTROPY_MAX_BYTES];
+    memset(partialEntropy, 0, sizeof(partialEntropy));
+    pack_indices(indices, count, partialEntropy);
+
+    /* the free bits are the lowest bits of the last entropy byte */
+    unsigned char msgs[128][ENTROPY_MAX_BYTES];
+    unsigned char digests[128][32];
+
+    for (int v = 0; v < candidates; v++) {
+        memcpy(msgs[v], partialEntropy, (size_t) entBytes);
+        msgs[v][entBytes - 1] |= (unsigned char) v;
+    }
+
+    sha256_short_batch(msgs[0], ENTROPY_MAX_BYTES, (size_t) entBytes, candidates, digests);
+
+    for (int v = 0; v < candidates; v++) {
+        int last = (v << csBits) | (digests[v][0] >> (8 - csBits));
+        printf("%s\n", words[last]);
+    }
+}
+
+/*
+ * This function adds one to a big-endian counter and returns the index of
+ * the most significant byte that changed, or -1 when the counter wrapped.
+ */
+
+static int increment_entropy(unsigned char *entropy, int entBytes) {
+
+    for (int i = entBytes - 1; i >= 0; i--) {
+        if (++entropy[i] != 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * This function prints count consecutive mnemonic sentences, starting at
+ * the entropy given as a hex string, in counter order.
+ *
+ * Entropy is advanced as a big-endian counter. Only the words that cover
+ * changed bytes are looked up again, together with the checksum word, and
+ * the text of the unchanged leading words is kept in the output line. In
+ * the common case only the last one or two words are rewritten per step.
+ */
+
+void enumerate_mnemonics(int entropysize, const char *start, unsigned long long count) {
+
+    if (!(entropysize >= 128 && entropysize <= 256 && entropysize % 32 == 0)) {
+        fprintf(stderr,
+                "ERROR: Only the following values for entropy bit sizes may be used: 128, 160, 192, 224, and 256\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int entBytes = entropysize / 8;
+    int ms = ENT_BITS_TO_MS(entropysize);
+    size_t digits = strlen(start);
+
+    if (digits == 0 || digits > (size_t) entBytes * 2) {
+        fprintf(stderr, "ERROR: Start entropy must be 1 to %d hex digits.\n", entBytes * 2);
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < digits; i++) {
+        if (!isxdigit((unsigned char) start[i])) {
+            fprintf(stderr, "ERROR: Start entropy must be a hex value.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* left-pad the start value to the full entropy width */
+    char hexStr[ENTROPY_MAX_BYTES * 2 + 1];
+    memset(hexStr, '0', (size_t) entBytes * 2 - digits);
+    strcpy(hexStr + entBytes * 2 - digits, start);
+
+    unsigned char *startBytes = hexstr_to_char(hexStr);
+    unsigned char batch[MNEMONIC_BATCH][ENTROPY_MAX_BYTES];
+    unsigned char digests[MNEMONIC_BATCH][32];
+    int firstChanged[MNEMONIC_BATCH];
+
+    memcpy(batch[0], startBytes, (size_t) entBytes);
+    free(startBytes);
+
+    setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+    int indices[MNEMONIC_MAX_WORDS];
+    char line[MNEMONIC_MAX_BYTES];
+    size_t offsets[MNEMONIC_MAX_WORDS + 1];
+    bool wrapped = false;
+
+    /* the first sentence is built in full */
+    firstChanged[0] = 0;
+    offsets[0] = 0;
+
+    while (count > 0 && !wrapped) {
+
+        /* fill a batch of consecutive entropies and hash them together */
+        int n = 1;
+        while (n < MNEMONIC_BATCH && (unsigned long long) n < count) {
+            memcpy(batch[n], batch[n - 1], (size_t) entBytes);
+            int changed = increment_entropy(batch[n], entBytes);
+            if (changed < 0) {
+                break;
+            }
+            firstChanged[n] = changed * 8 / 11;
+            n++;
+        }
+
+        sha256_short_batch(batch[0], ENTROPY_MAX_BYTES, (size_t) entBytes, n, digests);
+
+        for (int b = 0; b < n; b++) {
+
+            unsigned char segment[ENTROPY_MAX_BYTES + 1];
+            memcpy(segment, batch[b], (size_t) entBytes);
+            segment[entBytes] = digests[b][0];
+
+            /* words from firstChanged on, plus the checksum word, are stale */
+            int from = firstChanged[b];
+            unpack_indices(segment, from, ms, indices);
+
+            if (scan_active()) {
+                scan_mnemonic(indices, ms);
+                continue;
+            }
+
+            for (int i = from; i < ms; i++) {
+                size_t len = strlen(words[indices[i]]);
+                memcpy(line + offsets[i], words[indices[i]], len);
+                line[offsets[i] + len] = i == ms - 1 ? '\n' : ' ';
+                offsets[i + 1] = offsets[i] + len + 1;
+            }
+
+            fwrite(line, 1, offsets[ms], stdout);
+        }
+
+        count -= (unsigned long long) n;
+
+        if (count > 0) {
+            /* carry the last entropy of this batch into the next one */
+            memcpy(batch[0], batch[n - 1], (size_t) entBytes);
+            int changed = increment_entropy(batch[0], entBytes);
+            if (changed < 0) {
+                wrapped = true;
+            } else {
+                firstChanged[0] = changed * 8 / 11;
+            }
+        }
+    }
+
+    fflush(stdout);
+
+    if (wrapped) {
+        fprintf(stderr, "Reached the end of the %d-bit entropy range.\n", entropysize);
+    }
+}
+
+/*
+ * This function writes the health summary to the stats file ("-" for
+ * stderr).
+ */
+
+static void write_health_summary(const struct health_stats *stats, const char *statsFile) {
+
+    FILE *fp = strcmp(statsFile, "-") == 0 ? stderr : fopen(statsFile, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "ERROR: Cannot write stats file %s.\n", statsFile);
+        exit(EXIT_FAILURE);
+    }
+    health_write_summary(stats, fp);
+    if (fp != stderr) {
+        fclose(fp);
+    }
+}
+
+/*
+ * This function prints count random mnemonic sentences. Entropy is drawn
+ * from RAND_bytes a batch at a time and hashed in the same batch.
+ *
+ * With a stats file the entropy stream also runs through the SP 800-90B
+ * health tests before any sentence of a batch is written. A failing test
+ * aborts generation. The summary is written to the stats file ("-" for
+ * stderr) when generation completes or a test fails.
+ */
+
+void generate_mnemonics(int entropysize, unsigned long long count, const char *statsFile) {
+
+    if (!(entropysize >= 128 && entropysize <= 256 && entropysize % 32 == 0)) {
+        fprintf(stderr,
+                "ERROR: Only the following values for entropy bit sizes may be used: 128, 160, 192, 224, and 256\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int entBytes = entropysize / 8;
+    int ms = ENT_BITS_TO_MS(entropysize);
+
+    static struct health_stats stats;
+    if (statsFile != NULL) {
+        health_init(&stats);
+    }
+
+    unsigned char batch[MNEMONIC_BATCH * ENTROPY_MAX_BYTES];
+    unsigned char digests[MNEMONIC_BATCH][32];
+    int indices[MNEMONIC_MAX_WORDS];
+
+    setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+    while (count > 0) {
+
+        int n = count < MNEMONIC_BATCH ? (int) count : MNEMONIC_BATCH;
+
+        /* OpenSSL */
+        if (RAND_bytes(batch, n * entBytes) != 1) {
+            fflush(stdout);
+            fprintf(stderr, "ERROR: RAND_bytes failed, no entropy available.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        if (statsFile != NULL && health_test_bytes(&stats, batch, (size_t) (n * entBytes)) != 0) {
+            fflush(stdout);
+            fprintf(stderr, "ERROR: Entropy health test failed, generation aborted.\n");
+            write_health_summary(&stats, statsFile);
+            exit(EXIT_FAILURE);
+        }
+
+        sha256_short_batch(batch, (size_t) entBytes, (size_t) entBytes, n, digests);
+
+        if (audit_active()) {
+            audit_add_batch(batch, (size_t) entBytes, entBytes, n);
+        }
+
+        for (int b = 0; b < n; b++) {
+            entropy_to_indices(batch + b * entBytes, entBytes, digests[b], indices);
+            if (statsFile != NULL) {
+                health_count_words(&stats, indices, ms);
+            }
+            if (scan_active()) {
+                scan_mnemonic(indices, ms);
+            } else {
+                write_mnemonic(stdout, indices, ms);
+            }
+        }
+
+        count -= (unsigned long long) n;
+    }
+
+    fflush(stdout);
+
+    if (statsFile != NULL) {
+        write_health_summary(&stats, statsFile);
+    }
+}
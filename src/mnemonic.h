@@ -0,0 +1,95 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * mnemonic.h (header)
+ * Bit-level mnemonic functions working on 11-bit word indices.
+ *
+ */
+
+#ifndef BIP39C_MNEMONIC_H
+#define BIP39C_MNEMONIC_H
+
+#include <stdio.h>
+
+/*
+ * Defines
+ */
+
+#define MNEMONIC_MAX_WORDS  24
+#define ENTROPY_MAX_BYTES   32
+
+/* longest word accepted from a language file, in bytes; the longest real
+ * words are Korean at 33 bytes in NFKD, and load_wordlist() rejects more */
+#define WORD_MAX_BYTES      48
+
+/* buffer size for a formatted sentence */
+#define MNEMONIC_MAX_BYTES  (MNEMONIC_MAX_WORDS * (WORD_MAX_BYTES + 1) + 1)
+
+/* stdout buffer used by the bulk modes */
+#define OUTPUT_BUFFER_SIZE  (1 << 16)
+
+/* placeholder index for a "?" in a mnemonic pattern */
+#define WORD_UNKNOWN        (-1)
+
+/* entropies hashed per batch by the bulk modes */
+#define MNEMONIC_BATCH      64
+
+/* ENT and CS bit counts for a mnemonic sentence of MS words */
+#define MS_TO_ENT_BITS(ms)  ((ms) * 32 / 3)
+#define MS_TO_CS_BITS(ms)   ((ms) / 3)
+
+/* MS words for an entropy of ENT bits */
+#define ENT_BITS_TO_MS(ent) ((ent) * 3 / 32)
+
+/*
+ * Function declarations
+ */
+
+int word_index(const char *word);
+
+int parse_mnemonic(const char *sentence, int indices[], int maxWords);
+
+int parse_mnemonic_pattern(const char *pattern, int indices[], int maxWords);
+
+struct wordlist;
+
+int parse_mnemonic_wordlist(struct wordlist *wl, const char *sentence, int indices[], int maxWords);
+
+void pack_indices(const int indices[], int count, unsigned char *bytes);
+
+void unpack_indices(const unsigned char *bytes, int first, int count, int indices[]);
+
+void entropy_to_indices(const unsigned char *entropy, int entBytes, const unsigned char *digest,
+                        int indices[]);
+
+size_t format_mnemonic(char *sentence, size_t size, const int indices[], int count);
+
+void write_mnemonic(FILE *fp, const int indices[], int count);
+
+void get_final_words(const char *partial);
+
+void generate_mnemonics(int entropysize, unsigned long long count, const char *statsFile);
+
+void enumerate_mnemonics(int entropysize, const char *start, unsigned long long count);
+
+#endif //BIP39C_MNEMONIC_H
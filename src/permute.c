@@ -0,0 +1,445 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * permute.c (source)
+ * Recovery of the word order of a mnemonic sentence.
+ *
+ * All words are known but not their order. The orderings are walked as a
+ * tree, one position per level, over the distinct words left, so repeated
+ * words do not produce the same ordering twice. Each level writes the
+ * 11 bits of its word straight into the packed ENT+CS bit string, so an
+ * ordering shares all the work of its prefix and a leaf costs one 11-bit
+ * store. Leaves are hashed in batches and only orderings with a valid
+ * checksum go on to PBKDF2. The subtrees under the first levels are
+ * handed out to worker threads.
+ *
+ */
+
+#include "permute.h"
+#include "bip39c.h"
+#include "conversion.h"
+#include "crypto.h"
+#include "mnemonic.h"
+#include "scan.h"
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+
+/* subtrees per thread the first levels are split into, at least */
+#define TASKS_PER_THREAD    8
+
+/* packed buffer, with slack for the 3-byte window of set_word() */
+#define PACKED_BYTES        (ENTROPY_MAX_BYTES + 2)
+
+/*
+ * Shared state of an order recovery.
+ */
+
+struct order_job {
+    int ms;
+    int entBytes;
+    int csBits;
+
+    /* index per position, WORD_UNKNOWN where the order is searched */
+    int fixed[MNEMONIC_MAX_WORDS];
+    int freePos[MNEMONIC_MAX_WORDS];
+    int freeCnt;
+
+    /* distinct words left to place and their multiplicity */
+    int values[MNEMONIC_MAX_WORDS];
+    int valueCount[MNEMONIC_MAX_WORDS];
+    int distinct;
+
+    unsigned char target[64];
+    int targetLen;
+    const char *passphrase;
+
+    /* prefixes of taskDepth free positions, as value numbers */
+    int taskDepth;
+    int taskCount;
+    int *tasks;
+
+    pthread_mutex_t lock;
+    int nextTask;
+    unsigned long long checked;
+    unsigned long long found;
+};
+
+/*
+ * Per-thread state: the packed bits of the current path and a batch of
+ * complete orderings waiting to be hashed.
+ */
+
+struct order_worker {
+    struct order_job *job;
+    unsigned char packed[PACKED_BYTES];
+    int counts[MNEMONIC_MAX_WORDS];
+    int lastValue;
+
+    int batchSize;
+    unsigned char batch[MNEMONIC_BATCH][PACKED_BYTES];
+    int batchLast[MNEMONIC_BATCH];
+    unsigned long long checked;
+};
+
+/*
+ * This function stores an 11-bit word index at a position of the packed
+ * bit string, replacing what the position held before.
+ */
+
+static inline void set_word(unsigned char *packed, int position, int index) {
+
+    int bit = position * 11;
+    int byte = bit >> 3;
+    int shift = 13 - (bit & 7);
+    unsigned int window = (unsigned int) packed[byte] << 16 | (unsigned int) packed[byte + 1] << 8 |
+                          packed[byte + 2];
+
+    window = (window & ~(0x7ffu << shift)) | ((unsigned int) index << shift);
+    packed[byte] = (unsigned char) (window >> 16);
+    packed[byte + 1] = (unsigned char) (window >> 8);
+    packed[byte + 2] = (unsigned char) window;
+}
+
+/*
+ * This function reports an ordering that passed the checksum, after the
+ * seed or address check when one was asked for.
+ */
+
+static void report_order(struct order_job *job, const unsigned char *packed) {
+
+    int indices[MNEMONIC_MAX_WORDS];
+    char sentence[MNEMONIC_MAX_BYTES];
+    unsigned char seed[64];
+    int found = 1;
+
+    unpack_indices(packed, 0, job->ms, indices);
+    format_mnemonic(sentence, sizeof(sentence), indices, job->ms);
+
+    if (job->targetLen > 0 || scan_active()) {
+        mnemonic_to_seed(sentence, job->passphrase, seed);
+        if (memcmp(seed, job->target, (size_t) job->targetLen) != 0) {
+            return;
+        }
+    }
+
+    if (scan_active()) {
+        found = scan_seed(seed, sentence, NULL);
+    } else {
+        printf("%s\n", sentence);
+        if (job->targetLen > 0) {
+            fflush(stdout);
+        }
+    }
+
+    pthread_mutex_lock(&job->lock);
+    job->found += (unsigned long long) found;
+    pthread_mutex_unlock(&job->lock);
+}
+
+/*
+ * This function hashes the waiting orderings and reports those whose
+ * last word carries the right checksum.
+ */
+
+static void flush_batch(struct order_worker *w) {
+
+    struct order_job *job = w->job;
+    unsigned char digests[MNEMONIC_BATCH][32];
+    int mask = (1 << job->csBits) - 1;
+
+    sha256_short_batch(w->batch[0], PACKED_BYTES, (size_t) job->entBytes, w->batchSize, digests);
+
+    for (int b = 0; b < w->batchSize; b++) {
+        if ((digests[b][0] >> (8 - job->csBits)) == (w->batchLast[b] & mask)) {
+            report_order(job, w->batch[b]);
+        }
+    }
+
+    w->checked += (unsigned long long) w->batchSize;
+    w->batchSize = 0;
+}
+
+/*
+ * This function walks the orderings below free position depth.
+ */
+
+static void walk_orders(struct order_worker *w, int depth) {
+
+    struct order_job *job = w->job;
+    int position = job->freePos[depth];
+
+    for (int v = 0; v < job->distinct; v++) {
+
+        if (w->counts[v] == 0) {
+            continue;
+        }
+
+        set_word(w->packed, position, job->values[v]);
+
+        if (depth == job->freeCnt - 1) {
+            /* a complete ordering: queue it for hashing */
+            memcpy(w->batch[w->batchSize], w->packed, PACKED_BYTES);
+            w->batchLast[w->batchSize] = position == job->ms - 1 ? job->values[v] : w->lastValue;
+            if (++w->batchSize == MNEMONIC_BATCH) {
+                flush_batch(w);
+            }
+            continue;
+        }
+
+        w->counts[v]--;
+        walk_orders(w, depth + 1);
+        w->counts[v]++;
+    }
+}
+
+/*
+ * This function collects the prefixes of the first free positions that
+ * the threads take as tasks.
+ */
+
+static void collect_tasks(struct order_job *job, int counts[], int prefix[], int depth) {
+
+    if (depth == job->taskDepth) {
+        memcpy(job->tasks + job->taskCount * job->taskDepth, prefix, sizeof(int) * job->taskDepth);
+        job->taskCount++;
+        return;
+    }
+
+    for (int v = 0; v < job->distinct; v++) {
+        if (counts[v] == 0) {
+            continue;
+        }
+        prefix[depth] = v;
+        counts[v]--;
+        collect_tasks(job, counts, prefix, depth + 1);
+        counts[v]++;
+    }
+}
+
+/*
+ * Worker thread: take the next prefix, walk its subtree, repeat.
+ */
+
+static void *order_thread(void *arg) {
+
+    struct order_job *job = arg;
+    struct order_worker *w = calloc(1, sizeof(*w));
+
+    w->job = job;
+
+    for (;;) {
+
+        pthread_mutex_lock(&job->lock);
+        int task = job->nextTask++;
+        pthread_mutex_unlock(&job->lock);
+
+        if (task >= job->taskCount) {
+            break;
+        }
+
+        /* fixed words and the task prefix */
+        memset(w->packed, 0, sizeof(w->packed));
+        memcpy(w->counts, job->valueCount, sizeof(w->counts));
+        for (int p = 0; p < job->ms; p++) {
+            if (job->fixed[p] != WORD_UNKNOWN) {
+                set_word(w->packed, p, job->fixed[p]);
+            }
+        }
+        w->lastValue = job->fixed[job->ms - 1];
+
+        const int *prefix = job->tasks + task * job->taskDepth;
+        for (int d = 0; d < job->taskDepth; d++) {
+            int v = prefix[d];
+            set_word(w->packed, job->freePos[d], job->values[v]);
+            if (job->freePos[d] == job->ms - 1) {
+                w->lastValue = job->values[v];
+            }
+            w->counts[v]--;
+        }
+
+        if (job->taskDepth == job->freeCnt) {
+            /* the prefix is a complete ordering */
+            memcpy(w->batch[w->batchSize], w->packed, PACKED_BYTES);
+            w->batchLast[w->batchSize] = w->lastValue;
+            if (++w->batchSize == MNEMONIC_BATCH) {
+                flush_batch(w);
+            }
+        } else {
+            walk_orders(w, job->taskDepth);
+        }
+    }
+
+    if (w->batchSize > 0) {
+        flush_batch(w);
+    }
+
+    pthread_mutex_lock(&job->lock);
+    job->checked += w->checked;
+    pthread_mutex_unlock(&job->lock);
+
+    free(w);
+    return NULL;
+}
+
+/*
+ * This function parses the 1-based positions, separated by commas, whose
+ * words are already in the right place.
+ */
+
+static void parse_fixed(struct order_job *job, const int indices[], const char *fixedPositions) {
+
+    bool fixed[MNEMONIC_MAX_WORDS] = {false};
+    const char *p = fixedPositions;
+
+    while (p != NULL && *p != '\0') {
+        char *end;
+        long position = strtol(p, &end, 10);
+        if (end == p || position < 1 || position > job->ms || (*end != ',' && *end != '\0')) {
+            fprintf(stderr, "ERROR: Fixed positions must be word numbers 1 to %d, separated by commas.\n",
+                    job->ms);
+            exit(EXIT_FAILURE);
+        }
+        fixed[position - 1] = true;
+        p = *end == ',' ? end + 1 : end;
+    }
+
+    for (int i = 0; i < job->ms; i++) {
+        if (fixed[i]) {
+            job->fixed[i] = indices[i];
+            continue;
+        }
+
+        job->fixed[i] = WORD_UNKNOWN;
+        job->freePos[job->freeCnt++] = i;
+
+        /* the free words as a multiset of distinct values */
+        int v = 0;
+        while (v < job->distinct && job->values[v] != indices[i]) {
+            v++;
+        }
+        if (v == job->distinct) {
+            job->values[job->distinct++] = indices[i];
+        }
+        job->valueCount[v]++;
+    }
+}
+
+/*
+ * This function searches the orderings of a sentence whose words are all
+ * known. Orderings with a valid checksum are printed, or only those whose
+ * root seed starts with the target or that have a known address.
+ */
+
+void recover_order(const char *sentence, const char *fixedPositions, const char *target,
+                   const char *passphrase, int threads) {
+
+    static struct order_job job;
+    int indices[MNEMONIC_MAX_WORDS];
+
+    memset(&job, 0, sizeof(job));
+
+    job.ms = parse_mnemonic(sentence, indices, MNEMONIC_MAX_WORDS);
+    if (job.ms < 0) {
+        exit(EXIT_FAILURE);
+    }
+    if (job.ms < 12 || job.ms % 3 != 0) {
+        fprintf(stderr,
+                "ERROR: Only the following word counts may be reordered: 12, 15, 18, 21, and 24\n");
+        exit(EXIT_FAILURE);
+    }
+
+    job.entBytes = MS_TO_ENT_BITS(job.ms) / 8;
+    job.csBits = MS_TO_CS_BITS(job.ms);
+    job.passphrase = passphrase != NULL ? passphrase : "";
+    parse_fixed(&job, indices, fixedPositions);
+
+    if (job.freeCnt == 0) {
+        fprintf(stderr, "ERROR: Every position is fixed, there is no order to search.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (target != NULL) {
+        size_t digits = strlen(target);
+        if (digits == 0 || digits % 2 != 0 || digits > 128) {
+            fprintf(stderr, "ERROR: Target seed must be 2 to 128 hex digits.\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < digits; i++) {
+            if (!isxdigit((unsigned char) target[i])) {
+                fprintf(stderr, "ERROR: Target seed must be a hex value.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        unsigned char *bytes = hexstr_to_char(target);
+        job.targetLen = (int) digits / 2;
+        memcpy(job.target, bytes, (size_t) job.targetLen);
+        free(bytes);
+    }
+
+    if (threads < 1) {
+        threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        if (threads < 1) {
+            threads = 1;
+        }
+    }
+
+    /* deep enough for TASKS_PER_THREAD subtrees per thread */
+    long tasks = 1;
+    job.taskDepth = 0;
+    while (job.taskDepth < job.freeCnt && tasks < (long) threads * TASKS_PER_THREAD) {
+        tasks *= job.freeCnt - job.taskDepth;
+        job.taskDepth++;
+    }
+
+    int counts[MNEMONIC_MAX_WORDS], prefix[MNEMONIC_MAX_WORDS];
+    memcpy(counts, job.valueCount, sizeof(counts));
+    job.tasks = malloc(sizeof(int) * (size_t) (tasks * (job.taskDepth > 0 ? job.taskDepth : 1)));
+    collect_tasks(&job, counts, prefix, 0);
+
+    pthread_mutex_init(&job.lock, NULL);
+    setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+    pthread_t *ids = malloc(sizeof(pthread_t) * (size_t) threads);
+    for (int t = 0; t < threads; t++) {
+        if (pthread_create(&ids[t], NULL, order_thread, &job) != 0) {
+            fprintf(stderr, "ERROR: Cannot start worker thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+    }
+
+    fflush(stdout);
+    fprintf(stderr, "Checked %llu orderings with %d threads, %llu found.\n", job.checked, threads, job.found);
+
+    free(ids);
+    free(job.tasks);
+    pthread_mutex_destroy(&job.lock);
+}
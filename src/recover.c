@@ -0,0 +1,541 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * recover.c (source)
+ * Recovery of mnemonic sentences with unknown words.
+ *
+ * A pattern such as "word word ? word ..." fixes the known words. The
+ * unknown words and the passphrase candidates form a keyspace where every
+ * candidate has a position, the cursor, so a search can be split into
+ * disjoint shards (-x i/N) and resumed from a checkpoint file after it was
+ * stopped. Candidates are
+ * filtered by the checksum before any PBKDF2 work is done; an unknown last
+ * word is derived from the checksum instead of being searched.
+ *
+ */
+
+#include "recover.h"
+#include "bip39c.h"
+#include "conversion.h"
+#include "crypto.h"
+#include "mnemonic.h"
+#include "scan.h"
+#include "wordlist.h"
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <string.h>
+#include <ctype.h>
+#include <signal.h>
+#include <time.h>
+
+/*
+ * Recovery job: the known words, the unknown positions with their radix
+ * and the optional seed target with its passphrase candidates.
+ */
+
+struct recovery {
+    int ms;
+    int entBytes;
+    int csBits;
+    int indices[MNEMONIC_MAX_WORDS];
+
+    /* unknown positions, fastest changing (rightmost) first */
+    int unknownCnt;
+    int unknown[MNEMONIC_MAX_WORDS];
+    int radix[MNEMONIC_MAX_WORDS];
+    bool lastUnknown;
+
+    /* the passphrase is the most significant digit of the cursor */
+    unsigned long long wordTotal;
+    unsigned long long total;
+
+    unsigned char target[64];
+    int targetLen;
+    char **passphrases;
+    int passCount;
+    bool passFromFile;
+    char passDigest[65];
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void request_stop(int sig) {
+    (void) sig;
+    stopRequested = 1;
+}
+
+/*
+ * This function reads one passphrase candidate per line and hashes the
+ * candidates, so a checkpoint is tied to the contents of the file.
+ */
+
+static void read_passphrases(struct recovery *rec, const char *passFile) {
+
+    FILE *fp = fopen(passFile, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "ERROR: Cannot read passphrase file %s.\n", passFile);
+        exit(EXIT_FAILURE);
+    }
+
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    int size = 0;
+    char *contents = NULL;
+    size_t contentsLen = 0, contentsCap = 0;
+
+    while ((len = getline(&line, &cap, fp)) != -1) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = '\0';
+        }
+        if (rec->passCount == size) {
+            size = size == 0 ? 64 : size * 2;
+            rec->passphrases = realloc(rec->passphrases, sizeof(char *) * size);
+        }
+        rec->passphrases[rec->passCount++] = strdup(line);
+
+        if (contentsLen + (size_t) len + 2 > contentsCap) {
+            contentsCap = (contentsLen + (size_t) len + 2) * 2;
+            contents = realloc(contents, contentsCap);
+        }
+        memcpy(contents + contentsLen, line, (size_t) len);
+        contentsLen += (size_t) len;
+        contents[contentsLen++] = '\n';
+        contents[contentsLen] = '\0';
+    }
+
+    free(line);
+    fclose(fp);
+
+    if (contents != NULL) {
+        sha256(contents, rec->passDigest);
+        free(contents);
+    }
+
+    if (rec->passCount == 0) {
+        fprintf(stderr, "ERROR: Passphrase file %s is empty.\n", passFile);
+        exit(EXIT_FAILURE);
+    }
+    rec->passFromFile = true;
+}
+
+/*
+ * This function parses the pattern and target and sizes the keyspace.
+ */
+
+static void setup_recovery(struct recovery *rec, const char *pattern, const char *target,
+                           const char *passphrase, const char *passFile) {
+
+    memset(rec, 0, sizeof(*rec));
+
+    rec->ms = parse_mnemonic_pattern(pattern, rec->indices, MNEMONIC_MAX_WORDS);
+    if (rec->ms < 0) {
+        exit(EXIT_FAILURE);
+    }
+    if (rec->ms < 12 || rec->ms % 3 != 0) {
+        fprintf(stderr,
+                "ERROR: Only the following word counts may be recovered: 12, 15, 18, 21, and 24\n");
+        exit(EXIT_FAILURE);
+    }
+
+    rec->entBytes = MS_TO_ENT_BITS(rec->ms) / 8;
+    rec->csBits = MS_TO_CS_BITS(rec->ms);
+    rec->wordTotal = 1;
+
+    for (int i = rec->ms - 1; i >= 0; i--) {
+        if (rec->indices[i] != WORD_UNKNOWN) {
+            continue;
+        }
+
+        /* an unknown last word only holds 11 - CS free entropy bits */
+        int radix = LANG_WORD_CNT;
+        if (i == rec->ms - 1) {
+            rec->lastUnknown = true;
+            radix = 1 << (11 - rec->csBits);
+        }
+
+        if (rec->wordTotal > ULLONG_MAX / radix) {
+            fprintf(stderr, "ERROR: Too many unknown words for one search.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        rec->unknown[rec->unknownCnt] = i;
+        rec->radix[rec->unknownCnt] = radix;
+        rec->unknownCnt++;
+        rec->wordTotal *= (unsigned long long) radix;
+    }
+
+    if (target != NULL) {
+        size_t digits = strlen(target);
+        if (digits == 0 || digits % 2 != 0 || digits > 128) {
+            fprintf(stderr, "ERROR: Target seed must be 2 to 128 hex digits.\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < digits; i++) {
+            if (!isxdigit((unsigned char) target[i])) {
+                fprintf(stderr, "ERROR: Target seed must be a hex value.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        unsigned char *bytes = hexstr_to_char(target);
+        rec->targetLen = (int) digits / 2;
+        memcpy(rec->target, bytes, (size_t) rec->targetLen);
+        free(bytes);
+    }
+
+    /* seeds are only derived for a target seed or known addresses */
+    if (target != NULL || scan_active()) {
+        if (passFile != NULL) {
+            read_passphrases(rec, passFile);
+        } else {
+            rec->passphrases = malloc(sizeof(char *));
+            rec->passphrases[0] = strdup(passphrase != NULL ? passphrase : "");
+            rec->passCount = 1;
+        }
+    } else if (passFile != NULL) {
+        fprintf(stderr, "ERROR: A passphrase file needs a target seed (-m) or addresses (-a).\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /* without seeds there is no passphrase digit */
+    unsigned long long passDigits = rec->passCount > 0 ? (unsigned long long) rec->passCount : 1;
+    if (rec->wordTotal > ULLONG_MAX / passDigits) {
+        fprintf(stderr, "ERROR: Too many unknown words and passphrases for one search.\n");
+        exit(EXIT_FAILURE);
+    }
+    rec->total = rec->wordTotal * passDigits;
+}
+
+/*
+ * This function turns a cursor into the digits of the unknown words and
+ * the passphrase number.
+ */
+
+static void cursor_to_digits(const struct recovery *rec, unsigned long long cursor, int digits[], int *pass) {
+
+    *pass = (int) (cursor / rec->wordTotal);
+    cursor %= rec->wordTotal;
+
+    for (int d = 0; d < rec->unknownCnt; d++) {
+        digits[d] = (int) (cursor % (unsigned long long) rec->radix[d]);
+        cursor /= (unsigned long long) rec->radix[d];
+    }
+}
+
+/*
+ * This function advances the digits by one like an odometer. When the
+ * word digits wrap around the next passphrase is taken.
+ */
+
+static void next_digits(const struct recovery *rec, int digits[], int *pass) {
+
+    for (int d = 0; d < rec->unknownCnt; d++) {
+        if (++digits[d] < rec->radix[d]) {
+            return;
+        }
+        digits[d] = 0;
+    }
+    (*pass)++;
+}
+
+/*
+ * This function reports a candidate that passed the checksum. Without a
+ * target or address filter every candidate is printed; otherwise its seed
+ * is derived with passphrase number pass and only a match is printed.
+ */
+
+static int report_candidate(const struct recovery *rec, const int indices[], int pass) {
+
+    char sentence[MNEMONIC_MAX_BYTES];
+    unsigned char seed[64];
+
+    format_mnemonic(sentence, sizeof(sentence), indices, rec->ms);
+
+    if (rec->passCount == 0) {
+        printf("%s\n", sentence);
+        return 1;
+    }
+
+    mnemonic_to_seed(sentence, rec->passphrases[pass], seed);
+    if (memcmp(seed, rec->target, (size_t) rec->targetLen) != 0) {
+        return 0;
+    }
+
+    if (scan_active()) {
+        return scan_seed(seed, sentence, rec->passFromFile ? rec->passphrases[pass] : NULL);
+    }
+
+    if (rec->passFromFile) {
+        printf("%s\t%s\n", sentence, rec->passphrases[pass]);
+    } else {
+        printf("%s\n", sentence);
+    }
+    fflush(stdout);
+
+    return 1;
+}
+
+/*
+ * This function reads a checkpoint and returns its cursor, or start when
+ * there is no checkpoint yet. A checkpoint of another job is an error.
+ */
+
+static unsigned long long read_checkpoint(const char *file, const char *job, int shardIndex, int shardCount,
+                                          unsigned long long start, unsigned long long end) {
+
+    FILE *fp = fopen(file, "r");
+    if (fp == NULL) {
+        return start;
+    }
+
+    char magic[32], savedJob[65];
+    int savedIndex, savedCount;
+    unsigned long long cursor, savedEnd;
+
+    int ok = fgets(magic, sizeof(magic), fp) != NULL &&
+             strncmp(magic, CHECKPOINT_MAGIC, strlen(CHECKPOINT_MAGIC)) == 0 &&
+             fscanf(fp, "job %64s\n", savedJob) == 1 &&
+             fscanf(fp, "shard %d/%d\n", &savedIndex, &savedCount) == 2 &&
+             fscanf(fp, "cursor %llu\n", &cursor) == 1 &&
+             fscanf(fp, "end %llu\n", &savedEnd) == 1;
+    fclose(fp);
+
+    if (!ok) {
+        fprintf(stderr, "ERROR: Checkpoint file %s is damaged.\n", file);
+        exit(EXIT_FAILURE);
+    }
+    if (strcmp(savedJob, job) != 0 || savedIndex != shardIndex || savedCount != shardCount ||
+        savedEnd != end || cursor < start || cursor > end) {
+        fprintf(stderr, "ERROR: Checkpoint file %s belongs to a different job or shard.\n", file);
+        exit(EXIT_FAILURE);
+    }
+
+    return cursor;
+}
+
+/*
+ * This function replaces the checkpoint atomically, so a job killed while
+ * writing still finds the previous one.
+ */
+
+static void write_checkpoint(const char *file, const char *job, int shardIndex, int shardCount,
+                             unsigned long long cursor, unsigned long long end) {
+
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", file);
+
+    FILE *fp = fopen(tmp, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "ERROR: Cannot write checkpoint file %s.\n", tmp);
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(fp, "%s\njob %s\nshard %d/%d\ncursor %llu\nend %llu\n", CHECKPOINT_MAGIC, job, shardIndex,
+            shardCount, cursor, end);
+    fflush(fp);
+    fsync(fileno(fp));
+    fclose(fp);
+
+    if (rename(tmp, file) != 0) {
+        fprintf(stderr, "ERROR: Cannot replace checkpoint file %s.\n", file);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+ * This function searches the unknown words of a pattern.
+ *
+ * The keyspace of the shard is walked in cursor order a batch at a time.
+ * Known words and unknown digits are packed, the batch is hashed together
+ * and only candidates with a valid checksum are reported. Results are
+ * flushed before every checkpoint, so a resumed job may repeat the results
+ * of its last interval but never loses one; merge_results() removes such
+ * duplicates.
+ */
+
+void recover_mnemonic(const char *pattern, const char *target, const char *passphrase,
+                      const char *passFile, const char *shard, const char *checkpointFile) {
+
+    static struct recovery rec;
+    setup_recovery(&rec, pattern, target, passphrase, passFile);
+
+    /* disjoint, contiguous slice of the keyspace for this shard */
+    int shardIndex = 0, shardCount = 1;
+    if (shard != NULL && (sscanf(shard, "%d/%d", &shardIndex, &shardCount) != 2 || shardCount < 1 ||
+                          shardIndex < 0 || shardIndex >= shardCount)) {
+        fprintf(stderr, "ERROR: Shard must be given as i/N with 0 <= i < N.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned long long base = rec.total / (unsigned long long) shardCount;
+    unsigned long long rem = rec.total % (unsigned long long) shardCount;
+    unsigned long long start = base * (unsigned long long) shardIndex +
+                               ((unsigned long long) shardIndex < rem ? (unsigned long long) shardIndex : rem);
+    unsigned long long end = start + base + ((unsigned long long) shardIndex < rem ? 1 : 0);
+
+    /* the job is identified by everything that shapes its keyspace or its matches */
+    char job[65], scanId[96];
+    char jobStr[MNEMONIC_MAX_BYTES + PATH_MAX + 256];
+    scan_job_id(scanId);
+    snprintf(jobStr, sizeof(jobStr), "%s\n%s\n%s\n%s\n%s\n%s", pattern, language->code,
+             target != NULL ? target : "", rec.passFromFile ? rec.passDigest : "",
+             passphrase != NULL && passFile == NULL ? passphrase : "", scanId);
+    sha256(jobStr, job);
+
+    unsigned long long cursor = start;
+    if (checkpointFile != NULL) {
+        cursor = read_checkpoint(checkpointFile, job, shardIndex, shardCount, start, end);
+        if (cursor > start) {
+            fprintf(stderr, "Resuming at %llu of %llu.\n", cursor - start, end - start);
+        }
+        signal(SIGINT, request_stop);
+        signal(SIGTERM, request_stop);
+    }
+
+    unsigned char batch[MNEMONIC_BATCH][ENTROPY_MAX_BYTES + 1];
+    unsigned char digests[MNEMONIC_BATCH][32];
+    int candidates[MNEMONIC_BATCH][MNEMONIC_MAX_WORDS];
+    int candidatePass[MNEMONIC_BATCH];
+    int digits[MNEMONIC_MAX_WORDS];
+    int pass;
+    int indices[MNEMONIC_MAX_WORDS];
+    int lastMask = (1 << rec.csBits) - 1;
+    unsigned long long found = 0;
+    time_t lastCheckpoint = time(NULL);
+
+    memcpy(indices, rec.indices, sizeof(indices));
+    cursor_to_digits(&rec, cursor, digits, &pass);
+    setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+    while (cursor < end && !stopRequested) {
+
+        int n = 0;
+        while (n < MNEMONIC_BATCH && cursor < end) {
+            for (int d = 0; d < rec.unknownCnt; d++) {
+                indices[rec.unknown[d]] = digits[d];
+            }
+            if (rec.lastUnknown) {
+                indices[rec.ms - 1] = digits[0] << rec.csBits;
+            }
+            memcpy(candidates[n], indices, sizeof(int) * rec.ms);
+            candidatePass[n] = pass;
+            pack_indices(indices, rec.ms, batch[n]);
+            next_digits(&rec, digits, &pass);
+            cursor++;
+            n++;
+        }
+
+        sha256_short_batch(batch[0], ENTROPY_MAX_BYTES + 1, (size_t) rec.entBytes, n, digests);
+
+        for (int b = 0; b < n; b++) {
+            int cs = digests[b][0] >> (8 - rec.csBits);
+            if (rec.lastUnknown) {
+                candidates[b][rec.ms - 1] |= cs;
+            } else if ((candidates[b][rec.ms - 1] & lastMask) != cs) {
+                continue;
+            }
+            found += (unsigned long long) report_candidate(&rec, candidates[b], candidatePass[b]);
+        }
+
+        if (checkpointFile != NULL && time(NULL) - lastCheckpoint >= CHECKPOINT_INTERVAL) {
+            fflush(stdout);
+            write_checkpoint(checkpointFile, job, shardIndex, shardCount, cursor, end);
+            lastCheckpoint = time(NULL);
+        }
+    }
+
+    fflush(stdout);
+    if (checkpointFile != NULL) {
+        write_checkpoint(checkpointFile, job, shardIndex, shardCount, cursor, end);
+    }
+
+    fprintf(stderr, "Searched %llu of %llu candidates in shard %d/%d, %llu found.\n", cursor - start,
+            end - start, shardIndex, shardCount, found);
+
+    if (stopRequested) {
+        fprintf(stderr, "Stopped, run the same command again, appending to the same results (>>), to resume.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static int compare_lines(const void *a, const void *b) {
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+/*
+ * This function merges the result files of several shards or runs and
+ * prints every distinct line once, in sorted order.
+ */
+
+void merge_results(int fileCount, char **files) {
+
+    char **lines = NULL;
+    size_t count = 0, size = 0;
+
+    for (int f = 0; f < fileCount; f++) {
+
+        FILE *fp = fopen(files[f], "r");
+        if (fp == NULL) {
+            fprintf(stderr, "ERROR: Cannot read result file %s.\n", files[f]);
+            exit(EXIT_FAILURE);
+        }
+
+        char *line = NULL;
+        size_t cap = 0;
+        ssize_t len;
+
+        while ((len = getline(&line, &cap, fp)) != -1) {
+            while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+                line[--len] = '\0';
+            }
+            if (len == 0) {
+                continue;
+            }
+            if (count == size) {
+                size = size == 0 ? 1024 : size * 2;
+                lines = realloc(lines, sizeof(char *) * size);
+            }
+            lines[count++] = strdup(line);
+        }
+
+        free(line);
+        fclose(fp);
+    }
+
+    qsort(lines, count, sizeof(char *), compare_lines);
+
+    for (size_t i = 0; i < count; i++) {
+        if (i == 0 || strcmp(lines[i], lines[i - 1]) != 0) {
+            printf("%s\n", lines[i]);
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        free(lines[i]);
+    }
+
+    free(lines);
+}
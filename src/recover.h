@@ -0,0 +1,50 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * recover.h (header)
+ * Recovery of mnemonic sentences with unknown words.
+ *
+ */
+
+#ifndef BIP39C_RECOVER_H
+#define BIP39C_RECOVER_H
+
+/*
+ * Defines
+ */
+
+/* seconds between checkpoint writes */
+#define CHECKPOINT_INTERVAL 30
+
+#define CHECKPOINT_MAGIC    "bip39c-checkpoint 1"
+
+/*
+ * Function declarations
+ */
+
+void recover_mnemonic(const char *pattern, const char *target, const char *passphrase,
+                      const char *passFile, const char *shard, const char *checkpointFile);
+
+void merge_results(int fileCount, char **files);
+
+#endif //BIP39C_RECOVER_H
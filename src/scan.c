@@ -0,0 +1,402 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * scan.c (source)
+ * Matching of derived addresses against a Bloom filter of known addresses.
+ *
+ * The filter file holds a header, a blocked Bloom filter and the sorted
+ * HASH160 payloads of all known addresses, and is memory-mapped. All bits
+ * of a key sit in one 64-byte block, so a lookup touches a single cache
+ * line however many addresses are loaded. A payload is already uniformly
+ * distributed, so its bytes are used as the Bloom hashes directly. Filter
+ * hits are confirmed by binary search in the sorted payloads.
+ *
+ * For each candidate the receive and change chains of the BIP-44 (P2PKH),
+ * BIP-49 (P2SH-P2WPKH) and BIP-84 (P2WPKH) accounts m/purpose'/0'/0' are
+ * derived up to the gap limit.
+ *
+ */
+
+#include "scan.h"
+#include "address.h"
+#include "bip39c.h"
+#include "crypto.h"
+#include "mnemonic.h"
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <openssl/sha.h>
+
+/*
+ * Filter file header, padded so the filter blocks start on a cache line.
+ */
+
+struct bloom_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t hashes;
+    uint64_t blocks;
+    uint64_t keys;
+    unsigned char reserved[32];
+};
+
+static const struct bloom_header *filter = NULL;
+static const uint64_t *filterBlocks = NULL;
+static const unsigned char *filterKeys = NULL;
+static size_t filterSize = 0;
+static int scanGap = SCAN_DEFAULT_GAP;
+static const char *scanPassphrase = "";
+
+static const unsigned int purposes[] = {44, 49, 84};
+
+static uint64_t read_le64(const unsigned char *p) {
+
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static uint32_t read_le32(const unsigned char *p) {
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+/*
+ * This function returns the block of a key and its bit positions inside
+ * the block, by double hashing from the key bytes.
+ */
+
+static uint64_t bloom_block(const unsigned char key[20], uint64_t blocks) {
+    return read_le64(key) % blocks;
+}
+
+static unsigned int bloom_bit(const unsigned char key[20], unsigned int j) {
+    return (read_le32(key + 8) + j * (read_le32(key + 12) | 1)) % BLOOM_BLOCK_BITS;
+}
+
+static int compare_keys(const void *a, const void *b) {
+    return memcmp(a, b, 20);
+}
+
+/*
+ * This function reads one address per line, builds the filter and writes
+ * it to the filter file. Empty lines and lines starting with # are
+ * skipped, as are addresses that do not carry a HASH160. Testnet and
+ * regtest addresses are rejected with a message, since only coin type 0'
+ * is derived and they could never match.
+ */
+
+void build_address_filter(const char *addressFile, const char *filterFile) {
+
+    FILE *fp = fopen(addressFile, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "ERROR: Cannot read address file %s.\n", addressFile);
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned char *keys = NULL;
+    uint64_t count = 0, size = 0, skipped = 0, testnet = 0;
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+
+    while ((len = getline(&line, &cap, fp)) != -1) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ')) {
+            line[--len] = '\0';
+        }
+        if (len == 0 || line[0] == '#') {
+            continue;
+        }
+        if (count == size) {
+            size = size == 0 ? 1 << 16 : size * 2;
+            keys = realloc(keys, size * 20);
+            if (keys == NULL) {
+                fprintf(stderr, "ERROR: Out of memory reading addresses.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        int rc = address_to_hash160(line, keys + count * 20);
+        if (rc == 0) {
+            count++;
+        } else if (rc == ADDRESS_TESTNET) {
+            if (testnet++ == 0) {
+                fprintf(stderr, "Skipping testnet address %s, only mainnet (coin type 0') paths are derived.\n",
+                        line);
+            }
+            skipped++;
+        } else {
+            skipped++;
+        }
+    }
+    free(line);
+    fclose(fp);
+
+    if (count == 0) {
+        fprintf(stderr, "ERROR: No usable addresses in %s.\n", addressFile);
+        exit(EXIT_FAILURE);
+    }
+
+    /* sorted and distinct for the exact confirmation */
+    qsort(keys, count, 20, compare_keys);
+    uint64_t distinct = 1;
+    for (uint64_t i = 1; i < count; i++) {
+        if (memcmp(keys + i * 20, keys + (distinct - 1) * 20, 20) != 0) {
+            memmove(keys + distinct * 20, keys + i * 20, 20);
+            distinct++;
+        }
+    }
+
+    struct bloom_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BLOOM_MAGIC, sizeof(header.magic));
+    header.version = BLOOM_VERSION;
+    header.hashes = BLOOM_HASHES;
+    header.blocks = (distinct * BLOOM_BITS_PER_KEY + BLOOM_BLOCK_BITS - 1) / BLOOM_BLOCK_BITS;
+    header.keys = distinct;
+
+    uint64_t *blocks = calloc(header.blocks, BLOOM_BLOCK_BITS / 8);
+    if (blocks == NULL) {
+        fprintf(stderr, "ERROR: Out of memory building the filter.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (uint64_t i = 0; i < distinct; i++) {
+        const unsigned char *key = keys + i * 20;
+        uint64_t *block = blocks + bloom_block(key, header.blocks) * (BLOOM_BLOCK_BITS / 64);
+        for (unsigned int j = 0; j < BLOOM_HASHES; j++) {
+            unsigned int bit = bloom_bit(key, j);
+            block[bit / 64] |= (uint64_t) 1 << (bit % 64);
+        }
+    }
+
+    FILE *out = fopen(filterFile, "wb");
+    if (out == NULL ||
+        fwrite(&header, sizeof(header), 1, out) != 1 ||
+        fwrite(blocks, BLOOM_BLOCK_BITS / 8, header.blocks, out) != header.blocks ||
+        fwrite(keys, 20, distinct, out) != distinct ||
+        fclose(out) != 0) {
+        fprintf(stderr, "ERROR: Cannot write filter file %s.\n", filterFile);
+        exit(EXIT_FAILURE);
+    }
+
+    if (testnet > 1) {
+        fprintf(stderr, "Skipped %llu testnet addresses in all.\n", (unsigned long long) testnet);
+    }
+    fprintf(stderr, "Filter %s: %llu addresses (%llu duplicates, %llu skipped), %llu bytes of filter.\n",
+            filterFile, (unsigned long long) distinct, (unsigned long long) (count - distinct),
+            (unsigned long long) skipped, (unsigned long long) header.blocks * (BLOOM_BLOCK_BITS / 8));
+
+    free(blocks);
+    free(keys);
+}
+
+/*
+ * This function maps a filter file and turns scanning on. Candidate
+ * mnemonics of every mode are then matched instead of printed.
+ */
+
+void scan_open(const char *filterFile, int gap, const char *passphrase) {
+
+    int fd = open(filterFile, O_RDONLY);
+    struct stat st;
+
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "ERROR: Cannot read filter file %s.\n", filterFile);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((size_t) st.st_size < sizeof(struct bloom_header)) {
+        fprintf(stderr, "ERROR: %s is not a filter file.\n", filterFile);
+        exit(EXIT_FAILURE);
+    }
+
+    void *map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "ERROR: Cannot map filter file %s.\n", filterFile);
+        exit(EXIT_FAILURE);
+    }
+
+    /* lookups land on random cache lines, read-ahead does not help */
+    madvise(map, (size_t) st.st_size, MADV_RANDOM);
+
+    filter = map;
+    filterSize = (size_t) st.st_size;
+    if (memcmp(filter->magic, BLOOM_MAGIC, sizeof(filter->magic)) != 0 || filter->version != BLOOM_VERSION ||
+        filter->hashes != BLOOM_HASHES || filter->blocks == 0 ||
+        (uint64_t) st.st_size != sizeof(struct bloom_header) + filter->blocks * (BLOOM_BLOCK_BITS / 8) +
+                                 filter->keys * 20) {
+        fprintf(stderr, "ERROR: %s is not a filter file of this version.\n", filterFile);
+        exit(EXIT_FAILURE);
+    }
+
+    filterBlocks = (const uint64_t *) ((const unsigned char *) map + sizeof(struct bloom_header));
+    filterKeys = (const unsigned char *) (filterBlocks + filter->blocks * (BLOOM_BLOCK_BITS / 64));
+
+    if (gap < 1) {
+        fprintf(stderr, "ERROR: The gap limit must be at least 1.\n");
+        exit(EXIT_FAILURE);
+    }
+    scanGap = gap;
+    scanPassphrase = passphrase != NULL ? passphrase : "";
+}
+
+bool scan_active(void) {
+    return filter != NULL;
+}
+
+/*
+ * This function identifies what a scan matches against, the SHA256 of the
+ * filter file and the gap limit, or writes an empty string without a
+ * filter. Checkpoints include it, so a resumed search cannot silently skip
+ * candidates that were never checked against other addresses.
+ */
+
+void scan_job_id(char id[96]) {
+
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+
+    if (filter == NULL) {
+        id[0] = '\0';
+        return;
+    }
+
+    SHA256((const unsigned char *) filter, filterSize, digest);
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
+        sprintf(id + i * 2, "%02x", digest[i]);
+    }
+    snprintf(id + SHA256_DIGEST_LENGTH * 2, 96 - SHA256_DIGEST_LENGTH * 2, " %d", scanGap);
+}
+
+/*
+ * This function tests a payload against the filter and confirms hits.
+ */
+
+static bool known_address(const unsigned char key[20]) {
+
+    const uint64_t *block = filterBlocks + bloom_block(key, filter->blocks) * (BLOOM_BLOCK_BITS / 64);
+
+    for (unsigned int j = 0; j < BLOOM_HASHES; j++) {
+        unsigned int bit = bloom_bit(key, j);
+        if (!((block[bit / 64] >> (bit % 64)) & 1)) {
+            return false;
+        }
+    }
+
+    return bsearch(key, filterKeys, filter->keys, 20, compare_keys) != NULL;
+}
+
+/*
+ * This function derives the addresses of a root seed and prints a line
+ * with the sentence, the passphrase (when given), the derivation path and
+ * the HASH160 for every known address. Returns the number of matches.
+ */
+
+int scan_seed(const unsigned char seed[64], const char *sentence, const char *passphrase) {
+
+    struct hd_node master, account;
+    unsigned char accountPub[33], chainPubs[2][33], chainCodes[2][32], key[20], script[22];
+    unsigned char (*pubs)[33] = malloc((size_t) scanGap * 33);
+    int found = 0;
+
+    hd_master(seed, &master);
+
+    for (size_t p = 0; p < sizeof(purposes) / sizeof(purposes[0]); p++) {
+
+        /* m/purpose'/0'/0' */
+        if (hd_child(&master, NULL, purposes[p] | HD_HARDENED, &account) != 0 ||
+            hd_child(&account, NULL, HD_HARDENED, &account) != 0 ||
+            hd_child(&account, NULL, HD_HARDENED, &account) != 0) {
+            continue;
+        }
+
+        /* one account key, then both chains and all addresses are public derivations */
+        hd_public_key(&account, accountPub);
+        hd_children_public(accountPub, account.chain, 0, 2, chainPubs, chainCodes);
+
+        for (unsigned int c = 0; c < 2; c++) {
+
+            if (chainPubs[c][0] == 0) {
+                continue;
+            }
+            hd_children_public(chainPubs[c], chainCodes[c], 0, scanGap, pubs, NULL);
+
+            for (int i = 0; i < scanGap; i++) {
+
+                if (pubs[i][0] == 0) {
+                    continue;
+                }
+                hash160(pubs[i], 33, key);
+
+                /* P2SH-P2WPKH pays to the hash of the witness program */
+                if (purposes[p] == 49) {
+                    script[0] = 0x00;
+                    script[1] = 0x14;
+                    memcpy(script + 2, key, 20);
+                    hash160(script, sizeof(script), key);
+                }
+
+                if (known_address(key)) {
+                    /* one write per line, scans may run on several threads */
+                    char line[MNEMONIC_MAX_BYTES + 256];
+                    char hex[41];
+                    for (int b = 0; b < 20; b++) {
+                        sprintf(hex + b * 2, "%02x", key[b]);
+                    }
+                    snprintf(line, sizeof(line), "%s\t%s%sm/%u'/0'/0'/%u/%d\t%s\n", sentence,
+                             passphrase != NULL ? passphrase : "", passphrase != NULL ? "\t" : "",
+                             purposes[p], c, i, hex);
+                    fputs(line, stdout);
+                    fflush(stdout);
+                    found++;
+                }
+            }
+        }
+    }
+
+    free(pubs);
+
+    return found;
+}
+
+/*
+ * This function scans a mnemonic with the passphrase given to scan_open().
+ */
+
+int scan_mnemonic(const int indices[], int count) {
+
+    char sentence[MNEMONIC_MAX_BYTES];
+    unsigned char seed[64];
+
+    format_mnemonic(sentence, sizeof(sentence), indices, count);
+    mnemonic_to_seed(sentence, scanPassphrase, seed);
+
+    return scan_seed(seed, sentence, NULL);
+}
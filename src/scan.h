@@ -0,0 +1,62 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * scan.h (header)
+ * Matching of derived addresses against a Bloom filter of known addresses.
+ *
+ */
+
+#ifndef BIP39C_SCAN_H
+#define BIP39C_SCAN_H
+
+#include <stdbool.h>
+
+/*
+ * Defines
+ */
+
+#define SCAN_DEFAULT_GAP    20
+
+#define BLOOM_MAGIC         "B39BLOOM"
+#define BLOOM_VERSION       1
+#define BLOOM_BLOCK_BITS    512     /* one 64-byte cache line per key */
+#define BLOOM_BITS_PER_KEY  16
+#define BLOOM_HASHES        8
+
+/*
+ * Function declarations
+ */
+
+void build_address_filter(const char *addressFile, const char *filterFile);
+
+void scan_open(const char *filterFile, int gap, const char *passphrase);
+
+bool scan_active(void);
+
+void scan_job_id(char id[96]);
+
+int scan_seed(const unsigned char seed[64], const char *sentence, const char *passphrase);
+
+int scan_mnemonic(const int indices[], int count);
+
+#endif //BIP39C_SCAN_H
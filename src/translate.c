@@ -0,0 +1,194 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * translate.c (source)
+ * Translation of mnemonic sentences between languages.
+ *
+ * Every language maps the same 11-bit index to a word, so a sentence is
+ * translated by looking up each word's index in the source language and
+ * writing the target word at that index. Entropy and checksum do not
+ * change and nothing is hashed. The root seed does change, since PBKDF2
+ * runs over the words themselves. Input is read and output written in large
+ * blocks, so a big archive is translated in one streaming pass.
+ *
+ */
+
+#include "translate.h"
+#include "mnemonic.h"
+#include "wordlist.h"
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+static char in[TRANSLATE_BLOCK + 1];
+static char out[TRANSLATE_BLOCK];
+static size_t outLen = 0;
+
+static void out_write(const char *data, size_t len) {
+
+    if (outLen + len > sizeof(out)) {
+        fwrite(out, 1, outLen, stdout);
+        outLen = 0;
+    }
+    memcpy(out + outLen, data, len);
+    outLen += len;
+}
+
+/*
+ * This function parses a sentence and returns its word count, or -1 when
+ * the words are not a mnemonic of 12, 15, 18, 21 or 24 words.
+ */
+
+static int parse_sentence(struct wordlist *wl, const char *sentence, int indices[]) {
+
+    int count = parse_mnemonic_wordlist(wl, sentence, indices, MNEMONIC_MAX_WORDS);
+    return count >= 12 && count % 3 == 0 ? count : -1;
+}
+
+/*
+ * This function finds the language of a sentence, trying the language of
+ * the previous sentence first. It returns the word count or -1.
+ */
+
+static int detect_and_parse(struct wordlist **wl, const char *sentence, int indices[]) {
+
+    if (*wl != NULL) {
+        int count = parse_sentence(*wl, sentence, indices);
+        if (count > 0) {
+            return count;
+        }
+    }
+
+    for (int i = 0; i < WORDLIST_CNT; i++) {
+        struct wordlist *candidate = load_wordlist(wordlist_codes[i]);
+        if (candidate == *wl) {
+            continue;
+        }
+        int count = parse_sentence(candidate, sentence, indices);
+        if (count > 0) {
+            *wl = candidate;
+            return count;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * This function translates one sentence per line from stdin to stdout.
+ * Empty lines are kept; lines that are not a sentence of the source
+ * language are reported and left out. Returns the number of such lines.
+ */
+
+int translate_mnemonics(const char *source, const char *target) {
+
+    struct wordlist *to = load_wordlist(target);
+    struct wordlist *from = NULL;
+    bool detect = strcmp(source, TRANSLATE_AUTO) == 0;
+
+    if (to == NULL || (!detect && (from = load_wordlist(source)) == NULL)) {
+        fprintf(stderr, "Language or language file does not exist.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t sepLen = strlen(to->separator);
+    size_t have = 0;
+    unsigned long long lineNo = 0;
+    int errors = 0;
+    bool eof = false, skipping = false;
+    int indices[MNEMONIC_MAX_WORDS];
+
+    while (!eof || have > 0) {
+
+        if (!eof) {
+            size_t n = fread(in + have, 1, TRANSLATE_BLOCK - have, stdin);
+            have += n;
+            eof = n == 0 && feof(stdin);
+        }
+
+        size_t pos = 0;
+        for (;;) {
+
+            char *nl = memchr(in + pos, '\n', have - pos);
+            if (nl == NULL && !(eof && pos < have)) {
+                break;
+            }
+
+            /* a last line without newline ends at the end of input */
+            size_t end = nl != NULL ? (size_t) (nl - in) : have;
+            in[end] = '\0';
+            if (end > pos && in[end - 1] == '\r') {
+                in[end - 1] = '\0';
+            }
+            char *line = in + pos;
+            pos = end + 1 < have ? end + 1 : have;
+
+            if (skipping) {
+                skipping = false;
+                continue;
+            }
+            lineNo++;
+
+            if (line[0] == '\0') {
+                out_write("\n", 1);
+                continue;
+            }
+
+            int count = detect ? detect_and_parse(&from, line, indices)
+                               : parse_sentence(from, line, indices);
+            if (count <= 0) {
+                fprintf(stderr, "ERROR: Line %llu is not a mnemonic in language %s.\n", lineNo,
+                        detect ? TRANSLATE_AUTO : source);
+                errors++;
+                continue;
+            }
+
+            for (int i = 0; i < count; i++) {
+                if (i > 0) {
+                    out_write(to->separator, sepLen);
+                }
+                out_write(to->words[indices[i]], to->lengths[indices[i]]);
+            }
+            out_write("\n", 1);
+        }
+
+        /* keep the partial line; a line filling the whole block is dropped */
+        if (pos == 0 && have == TRANSLATE_BLOCK) {
+            fprintf(stderr, "ERROR: Line %llu is too long.\n", ++lineNo);
+            errors++;
+            skipping = true;
+            have = 0;
+        } else {
+            memmove(in, in + pos, have - pos);
+            have -= pos;
+        }
+    }
+
+    fwrite(out, 1, outLen, stdout);
+    fflush(stdout);
+
+    return errors;
+}
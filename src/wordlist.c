@@ -0,0 +1,175 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * wordlist.c (source)
+ * Language word files and word lookups.
+ *
+ */
+
+#include "wordlist.h"
+#include "mnemonic.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The supported languages. Japanese sentences separate their words with
+ * an ideographic space. The word arrays stay in zero-initialized storage
+ * and are only touched for languages that are loaded.
+ */
+
+const char *const wordlist_codes[WORDLIST_CNT] = {"eng", "spa", "fra", "ita", "kor", "jpn", "sc", "tc"};
+
+static const char *const files[WORDLIST_CNT] = {
+    "english.txt", "spanish.txt", "french.txt", "italian.txt",
+    "korean.txt", "japanese.txt", "chinese-simplified.txt", "chinese-traditional.txt"
+};
+
+struct wordlist wordlists[WORDLIST_CNT];
+
+/*
+ * FNV-1a over the bytes of a word, for the lookup table.
+ */
+
+static uint32_t word_hash(const char *word, size_t len) {
+
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (unsigned char) word[i]) * 16777619u;
+    }
+    return h;
+}
+
+/*
+ * This function reads the language file once and loads an array of words for
+ * repeated use. It returns NULL for an unknown language code. Languages are
+ * only read when first asked for, so a run reads one file at most unless
+ * it translates.
+ */
+
+struct wordlist *load_wordlist(const char *code) {
+
+    struct wordlist *wl = NULL;
+    int lang;
+
+    for (lang = 0; lang < WORDLIST_CNT; lang++) {
+        if (strcmp(code, wordlist_codes[lang]) == 0) {
+            wl = &wordlists[lang];
+            break;
+        }
+    }
+    if (wl == NULL || wl->loaded) {
+        return wl;
+    }
+
+    wl->code = wordlist_codes[lang];
+    wl->file = files[lang];
+    wl->separator = strcmp(wl->code, "jpn") == 0 ? "\xe3\x80\x80" : " ";
+
+    char filepath[256];
+    snprintf(filepath, sizeof(filepath), "%s%s", WORD_FILE_DIR, wl->file);
+
+    FILE *fp = fopen(filepath, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "ERROR: Cannot open language file %s.\n", filepath);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Read the entire file into memory. */
+    char *source = NULL;
+    long bufsize = -1;
+    if (fseek(fp, 0L, SEEK_END) == 0) {
+        bufsize = ftell(fp);
+    }
+    if (bufsize < 0 || fseek(fp, 0L, SEEK_SET) != 0) {
+        fprintf(stderr, "ERROR: File size?\n");
+        exit(EXIT_FAILURE);
+    }
+    source = malloc(sizeof(char) * (bufsize + 1));
+    size_t newLen = fread(source, sizeof(char), (size_t) bufsize, fp);
+    if (ferror(fp) != 0) {
+        fprintf(stderr, "ERROR: File read.\n");
+        exit(EXIT_FAILURE);
+    }
+    source[newLen] = '\0';
+    fclose(fp);
+
+    /* the words point into the file buffer, which is kept */
+    int i = 0;
+    char *word = strtok(source, "\r\n");
+    while (word != NULL && i < LANG_WORD_CNT) {
+        size_t len = strlen(word);
+        if (len > WORD_MAX_BYTES) {
+            fprintf(stderr, "ERROR: Language file %s has a word longer than %d bytes.\n", filepath,
+                    WORD_MAX_BYTES);
+            exit(EXIT_FAILURE);
+        }
+        wl->words[i] = word;
+        wl->lengths[i] = (unsigned char) len;
+        i++;
+        word = strtok(NULL, "\r\n");
+    }
+
+    if (i != LANG_WORD_CNT) {
+        fprintf(stderr, "ERROR: Language file %s has %d words instead of %d.\n", filepath, i, LANG_WORD_CNT);
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < LANG_WORD_CNT; i++) {
+        uint32_t slot = word_hash(wl->words[i], wl->lengths[i]) & (WORDLIST_SLOTS - 1);
+        while (wl->slots[slot] != 0) {
+            slot = (slot + 1) & (WORDLIST_SLOTS - 1);
+        }
+        wl->slots[slot] = (unsigned short) (i + 1);
+    }
+
+    wl->loaded = true;
+    return wl;
+}
+
+/*
+ * This function returns the index of a word of len bytes, which need not
+ * end in a NUL, in a loaded language or -1 if the word is not in the list.
+ */
+
+int wordlist_index(const struct wordlist *wl, const char *word, size_t len) {
+
+    if (len > WORD_MAX_BYTES) {
+        return -1;
+    }
+
+    uint32_t slot = word_hash(word, len) & (WORDLIST_SLOTS - 1);
+    unsigned short entry;
+
+    while ((entry = wl->slots[slot]) != 0) {
+        int i = entry - 1;
+        if (wl->lengths[i] == len && memcmp(wl->words[i], word, len) == 0) {
+            return i;
+        }
+        slot = (slot + 1) & (WORDLIST_SLOTS - 1);
+    }
+
+    return -1;
+}
@@ -0,0 +1,72 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 David L. Whitehurst
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * wordlist.h (header)
+ * Language word files and word lookups.
+ *
+ */
+
+#ifndef BIP39C_WORDLIST_H
+#define BIP39C_WORDLIST_H
+
+#include "bip39c.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Defines
+ */
+
+#define WORD_FILE_DIR   "/usr/local/data/"
+#define WORDLIST_CNT    8
+#define WORDLIST_SLOTS  4096    /* power of two, twice LANG_WORD_CNT */
+
+/*
+ * One language: its word file, the words, and a hash table of word index
+ * plus one (0 for an empty slot) for lookups.
+ */
+
+struct wordlist {
+    const char *code;
+    const char *file;
+    const char *separator;
+    bool loaded;
+    char *words[LANG_WORD_CNT];
+    unsigned char lengths[LANG_WORD_CNT];
+    unsigned short slots[WORDLIST_SLOTS];
+};
+
+extern const char *const wordlist_codes[WORDLIST_CNT];
+
+extern struct wordlist wordlists[WORDLIST_CNT];
+
+/*
+ * Function declarations
+ */
+
+struct wordlist *load_wordlist(const char *code);
+
+int wordlist_index(const struct wordlist *wl, const char *word, size_t len);
+
+#endif //BIP39C_WORDLIST_H